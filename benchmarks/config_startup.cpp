@@ -0,0 +1,78 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <logger/include/Logger.hpp>
+#include <taskmasterd/include/jobs/ConfigLoader.hpp>
+
+/**
+ * Loads a config with many jobs the way the daemon does at startup, once by parsing the YAML and
+ * once from an up to date binary snapshot of the parsed configs.
+ */
+
+using Clock = std::chrono::steady_clock;
+using namespace taskmasterd;
+
+static double load(const std::string& path, const std::string& snapshot, usize& jobs)
+{
+    auto         start = Clock::now();
+    ConfigLoader loader(path, snapshot);
+
+    jobs = loader.load().size();
+
+    std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+    return elapsed.count();
+}
+
+int main(int argc, char** argv)
+{
+    u32         count    = argc > 1 ? std::stoul(argv[1]) : 10000;
+    u32         rounds   = argc > 2 ? std::stoul(argv[2]) : 3;
+    std::string path     = "/tmp/bench_config_startup." + std::to_string(getpid()) + ".yaml";
+    std::string snapshot = path + ".snapshot";
+
+    Logger::LogInterface::Initialize("bench_config_startup", Logger::LogLevel::None, false);
+
+    {
+        std::ofstream config(path);
+
+        config << "jobs:\n";
+        for (u32 i = 0; i < count; i++) {
+            config << "  job" << i << ":\n"
+                   << "    cmd: /bin/sleep " << i << "\n"
+                   << "    numprocs: 2\n"
+                   << "    autostart: false\n"
+                   << "    autorestart: unexpected\n"
+                   << "    exitcodes: [0, 2]\n"
+                   << "    stopsignal: TERM\n"
+                   << "    workingdir: /tmp\n"
+                   << "    env:\n"
+                   << "      JOB: job" << i << "\n"
+                   << "      MODE: bench\n";
+        }
+    }
+
+    usize jobs = 0;
+
+    // writes the snapshot that the following rounds start from
+    load(path, snapshot, jobs);
+
+    struct stat info;
+    stat(snapshot.c_str(), &info);
+    std::cout << "jobs: " << jobs << ", snapshot: " << info.st_size / 1024 << " KiB\n";
+
+    for (u32 i = 0; i < rounds; i++) {
+        double parsed   = load(path, "", jobs);
+        double restored = load(path, snapshot, jobs);
+
+        std::cout << "round " << i << ": yaml " << parsed << " ms, snapshot " << restored << " ms\n";
+    }
+
+    std::remove(path.c_str());
+    std::remove(snapshot.c_str());
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unordered_map>
+#include <vector>
+
+#include <ipc/include/FileDescriptor.hpp>
+#include <logger/include/Logger.hpp>
+#include <taskmasterd/include/core/EventManager.hpp>
+
+/**
+ * Compares the dispatch cost of the fd indexed handler table of the EventManager with the
+ * previous implementation that kept two unordered_maps of callbacks.
+ *
+ * Every registered fd is an eventfd with a non zero counter, so it is reported as readable on
+ * every epoll_wait and each iteration dispatches MAX_EVENTS callbacks.
+ */
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief The map based dispatcher as it was used by the EventManager before the handler table.
+ */
+class MapDispatcher : public ipc::FileDescriptor
+{
+public:
+    using EventCallback = std::function<void()>;
+
+    MapDispatcher()
+        : FileDescriptor(epoll_create1(0))
+    {
+        if (_fd == -1)
+            throw std::runtime_error("Failed to create epoll file descriptor");
+    }
+
+    void registerEvent(const FileDescriptor& handler, EventCallback read_callback)
+    {
+        struct epoll_event event{};
+        event.events  = EPOLLIN;
+        event.data.fd = handler.getFd();
+
+        if (epoll_ctl(_fd, EPOLL_CTL_ADD, handler.getFd(), &event) == -1)
+            throw std::runtime_error("Failed to update file descriptor in epoll: " + std::string(strerror(errno)));
+
+        _read_callbacks[handler.getFd()]  = read_callback;
+        _write_callbacks[handler.getFd()] = nullptr;
+    }
+
+    void handleEvents()
+    {
+        struct epoll_event events[MAX_EVENTS];
+
+        i32 num_events = epoll_wait(_fd, events, MAX_EVENTS, -1);
+        for (i32 i = 0; i < num_events; i++) {
+            i32 fd = events[i].data.fd;
+            if (events[i].events & EPOLLIN)
+                _read_callbacks.at(fd)();
+            if (events[i].events & EPOLLOUT)
+                _write_callbacks.at(fd)();
+        }
+    }
+
+private:
+    const static i32 MAX_EVENTS = 1024;
+
+    std::unordered_map<i32, EventCallback> _read_callbacks;
+    std::unordered_map<i32, EventCallback> _write_callbacks;
+};
+
+static std::vector<std::unique_ptr<ipc::FileDescriptor>> createReadableFds(u32 count)
+{
+    std::vector<std::unique_ptr<ipc::FileDescriptor>> fds;
+
+    fds.reserve(count);
+    for (u32 i = 0; i < count; i++) {
+        fds.emplace_back(std::make_unique<ipc::FileDescriptor>(eventfd(1, EFD_NONBLOCK)));
+        if (fds.back()->getFd() == -1)
+            throw std::runtime_error("Failed to create eventfd: " + std::string(strerror(errno)));
+    }
+    return fds;
+}
+
+template <typename Dispatcher> static double measure(Dispatcher& dispatcher, u32 iterations, u64& dispatched)
+{
+    auto start = Clock::now();
+
+    for (u32 i = 0; i < iterations; i++)
+        dispatcher.handleEvents();
+
+    std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+    return elapsed.count() / static_cast<double>(dispatched);
+}
+
+int main(int argc, char** argv)
+{
+    u32 fd_count   = argc > 1 ? std::stoul(argv[1]) : 4096;
+    u32 iterations = argc > 2 ? std::stoul(argv[2]) : 2000;
+
+    Logger::LogInterface::Initialize("bench_event_dispatch", Logger::LogLevel::None, false);
+
+    auto fds = createReadableFds(fd_count);
+
+    u64           map_dispatched = 0;
+    MapDispatcher map_dispatcher;
+    for (auto& fd : fds)
+        map_dispatcher.registerEvent(*fd, [&map_dispatched]() { map_dispatched++; });
+    double map_ns = measure(map_dispatcher, iterations, map_dispatched);
+
+    u64                       table_dispatched = 0;
+    taskmasterd::EventManager table_dispatcher(taskmasterd::EventManager::Backend::EPOLL);
+    for (auto& fd : fds)
+        table_dispatcher.registerEvent(*fd, [&table_dispatched]() { table_dispatched++; });
+    double table_ns = measure(table_dispatcher, iterations, table_dispatched);
+
+    std::cout << "fds: " << fd_count << ", iterations: " << iterations << "\n";
+    std::cout << "unordered_map dispatch: " << map_ns << " ns/event (" << map_dispatched << " events)\n";
+    std::cout << "handler table dispatch: " << table_ns << " ns/event (" << table_dispatched << " events)\n";
+
+    return 0;
+}
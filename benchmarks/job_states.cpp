@@ -0,0 +1,70 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+#include <logger/include/Logger.hpp>
+#include <taskmasterd/include/core/EventManager.hpp>
+#include <taskmasterd/include/jobs/Job.hpp>
+#include <taskmasterd/include/jobs/JobConfig.hpp>
+#include <taskmasterd/include/jobs/JobManager.hpp>
+
+/**
+ * Starts and stops a single job with a large numprocs. Every start time event and every exit
+ * makes the job check the states of all of its processes, which used to make a mass start or
+ * stop quadratic in the amount of processes.
+ */
+
+using Clock = std::chrono::steady_clock;
+using namespace taskmasterd;
+
+static double runUntil(Job& job, Job::State state, Clock::time_point start)
+{
+    while (job.getState() != state)
+        EventManager::getInstance().handleEvents();
+
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    return elapsed.count();
+}
+
+int main(int argc, char** argv)
+{
+    u32         numprocs = argc > 1 ? std::stoul(argv[1]) : 2000;
+    u32         rounds   = argc > 2 ? std::stoul(argv[2]) : 3;
+    std::string path     = "/tmp/bench_job_states." + std::to_string(getpid()) + ".yaml";
+
+    Logger::LogInterface::Initialize("bench_job_states", Logger::LogLevel::None, false);
+
+    std::ofstream(path) << "jobs:\n"
+                           "  bench:\n"
+                           "    cmd: /bin/sleep 1000\n"
+                           "    numprocs: "
+                        << numprocs
+                        << "\n"
+                           "    autostart: false\n"
+                           "    starttime: 0\n"
+                           "    stoptime: 5\n";
+
+    {
+        JobManager manager(path);
+        Job        job(JobConfig::getJobConfigs(path).at("bench"), manager);
+
+        std::cout << "numprocs: " << numprocs << "\n";
+        for (u32 i = 0; i < rounds; i++) {
+            auto start = Clock::now();
+            job.start();
+            double started = runUntil(job, Job::State::RUNNING, start);
+
+            start = Clock::now();
+            job.stop();
+            double stopped = runUntil(job, Job::State::STOPPED, start);
+
+            std::cout << "round " << i << ": start " << started * 1000 << " ms, stop " << stopped * 1000 << " ms\n";
+        }
+    }
+
+    std::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <logger/include/Logger.hpp>
+#include <taskmasterd/include/jobs/Journal.hpp>
+
+/**
+ * Measures the journal: appends the output of many processes in chunks of a fixed size, then
+ * queries the output of the last percent of the appends and all output. The recent query seeks
+ * with the sparse index, the full query scans every segment, the difference is what the index
+ * saves a 'logs --since' of recent output. The newest query walks back from the end until it has
+ * the output that 'logs' shows without '--since'.
+ */
+
+using Clock = std::chrono::steady_clock;
+using taskmasterd::Journal;
+
+static const char* JOURNAL_PATH = "/tmp/bench_journal";
+
+static i64 getWallClock()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static void query(const char* name, Journal& journal, i64 since)
+{
+    usize records = 0;
+    usize bytes   = 0;
+    auto  start   = Clock::now();
+
+    journal.read(since, [&](const Journal::Record& record) {
+        records++;
+        bytes += record.data.size();
+    });
+
+    std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+    std::cout << name << ": " << records << " records, " << bytes / (1024 * 1024) << " MB in " << elapsed.count() << " ms\n";
+}
+
+static void queryNewest(const char* name, Journal& journal, usize wanted)
+{
+    usize records = 0;
+    usize bytes   = 0;
+    auto  start   = Clock::now();
+
+    journal.readNewest(Journal::SEGMENT_SIZE, [&](const std::vector<Journal::Record>& block) {
+        for (const Journal::Record& record : block) {
+            records++;
+            bytes += record.data.size();
+        }
+        return bytes < wanted;
+    });
+
+    std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+    std::cout << name << ": " << records << " records, " << bytes / 1024 << " KB in " << elapsed.count() << " ms\n";
+}
+
+int main(int argc, char** argv)
+{
+    usize megabytes = argc > 1 ? std::stoul(argv[1]) : 512;
+    usize chunk     = argc > 2 ? std::stoul(argv[2]) : 4096;
+    usize processes = 100;
+
+    Logger::LogInterface::Initialize("bench_journal", Logger::LogLevel::Sparse, true);
+
+    std::filesystem::remove_all(JOURNAL_PATH);
+    setenv("TASKMASTERD_JOURNAL", JOURNAL_PATH, 1);
+
+    Journal&                     journal = Journal::getInstance();
+    std::vector<char>            data(chunk, 'x');
+    std::vector<Journal::Source> sources;
+
+    for (usize i = 0; i < processes; i++)
+        sources.push_back(Journal::Source{"job_" + std::to_string(i % 10), static_cast<u32>(i / 10), Journal::Stream::STDOUT});
+
+    usize count  = megabytes * 1024 * 1024 / chunk;
+    i64   recent = 0;
+    auto  start  = Clock::now();
+
+    for (usize i = 0; i < count; i++) {
+        if (i == count - count / 100)
+            recent = getWallClock();
+        journal.append(sources[i % processes], data.data(), data.size());
+    }
+
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    std::cout << "journal: " << megabytes << " MB in records of " << chunk << " bytes\n";
+    std::cout << "append: " << megabytes / elapsed.count() << " MB/s, " << elapsed.count() * 1e9 / count << " ns per record\n";
+
+    query("last 1% (index)", journal, recent);
+    query("all (scan)", journal, 0);
+    queryNewest("newest 1 MB (walk back)", journal, 1024 * 1024);
+
+    std::filesystem::remove_all(JOURNAL_PATH);
+    return 0;
+}
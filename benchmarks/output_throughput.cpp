@@ -0,0 +1,97 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include <logger/include/Logger.hpp>
+#include <taskmasterd/include/core/EventManager.hpp>
+#include <taskmasterd/include/jobs/OutputStream.hpp>
+
+/**
+ * Measures how fast the daemon ships the output of a process that writes at full speed: a child
+ * writes a fixed amount of bytes into the pipe of an OutputStream while the event loop moves it to
+ * a log file and the ring buffer. Reports the throughput and the CPU time the daemon spent on it,
+ * with the output copied through the daemon and with splice/tee.
+ */
+
+using Clock = std::chrono::steady_clock;
+using taskmasterd::EventManager;
+using taskmasterd::OutputStream;
+
+static const char* LOG_PATH = "/tmp/bench_output_throughput.log";
+
+static double getCpuTime()
+{
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+static void measure(const char* name, bool splice, const std::optional<std::string>& sink, usize megabytes, usize chunk)
+{
+    setenv("TASKMASTERD_SPLICE", splice ? "1" : "0", 1);
+    unlink(LOG_PATH);
+
+    OutputStream        stream(name);
+    ipc::FileDescriptor pipe  = stream.open(sink, taskmasterd::JobConfig::Rotation{0, 0, 0, false});
+    usize               total = megabytes * 1024 * 1024;
+
+    auto   start = Clock::now();
+    double cpu   = getCpuTime();
+
+    pid_t pid = fork();
+    if (pid == -1)
+        throw std::runtime_error("Fork failed: " + std::string(strerror(errno)));
+    if (pid == 0) {
+        std::vector<char> data(chunk, 'x');
+
+        for (usize written = 0; written < total;) {
+            isize size = write(pipe.getFd(), data.data(), std::min(chunk, total - written));
+            if (size <= 0)
+                _exit(1);
+            written += size;
+        }
+        _exit(0);
+    }
+    pipe.close();
+
+    while (stream.getFd() != -1)
+        EventManager::getInstance().handleEvents();
+    waitpid(pid, nullptr, 0);
+
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    double                        used    = getCpuTime() - cpu;
+
+    struct stat info;
+    if (stream.getBuffer().getWritten() != total || (sink.has_value() && (stat(LOG_PATH, &info) != 0 || static_cast<usize>(info.st_size) != total)))
+        throw std::runtime_error(std::string(name) + ": lost output");
+
+    std::cout << name << ": " << total / elapsed.count() / (1024 * 1024) << " MB/s, daemon CPU " << used / elapsed.count() * 100 << "%, "
+              << used * 1e6 / megabytes << " us CPU per MB\n";
+}
+
+int main(int argc, char** argv)
+{
+    usize megabytes = argc > 1 ? std::stoul(argv[1]) : 2048;
+    usize chunk     = argc > 2 ? std::stoul(argv[2]) : 64 * 1024;
+
+    Logger::LogInterface::Initialize("bench_output_throughput", Logger::LogLevel::Sparse, true);
+
+    std::cout << "output: " << megabytes << " MB in writes of " << chunk << " bytes\n";
+    measure("copy to file", false, LOG_PATH, megabytes, chunk);
+    measure("splice to file", true, LOG_PATH, megabytes, chunk);
+    measure("copy to memory", false, std::nullopt, megabytes, chunk);
+    measure("splice to memory", true, std::nullopt, megabytes, chunk);
+    unlink(LOG_PATH);
+
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include <ipc/include/FileDescriptor.hpp>
+#include <logger/include/Logger.hpp>
+#include <taskmasterd/include/core/EventManager.hpp>
+
+/**
+ * Measures process churn throughput of the EventManager backends: a fixed amount of short lived
+ * processes is kept in flight, every exit is noticed through its pidfd and immediately replaced
+ * by a new process until the total amount of processes has been spawned.
+ */
+
+using Clock = std::chrono::steady_clock;
+using taskmasterd::EventManager;
+
+class Churn
+{
+public:
+    Churn(EventManager& events, u32 total)
+        : _events(events)
+        , _remaining(total)
+        , _running(0)
+    {
+    }
+
+    void spawn()
+    {
+        if (_remaining == 0)
+            return;
+        _remaining--;
+
+        pid_t pid = fork();
+        if (pid == -1)
+            throw std::runtime_error("Fork failed: " + std::string(strerror(errno)));
+        if (pid == 0) {
+            char* const argv[] = {const_cast<char*>("/bin/true"), nullptr};
+            execve(argv[0], argv, environ);
+            _exit(127);
+        }
+
+        auto  pidfd = std::make_unique<ipc::FileDescriptor>(pidfd_open(pid, 0));
+        auto* raw   = pidfd.get();
+        if (raw->getFd() == -1)
+            throw std::runtime_error("Failed to open pidfd: " + std::string(strerror(errno)));
+
+        _events.registerEvent(*raw, [this, raw, pid]() { onExit(*raw, pid); });
+        if (static_cast<usize>(raw->getFd()) >= _pidfds.size())
+            _pidfds.resize(raw->getFd() + 1);
+        _pidfds[raw->getFd()] = std::move(pidfd);
+        _running++;
+    }
+
+    void onExit(ipc::FileDescriptor& pidfd, pid_t pid)
+    {
+        i32 status;
+
+        waitpid(pid, &status, 0);
+        _events.unregisterEvent(pidfd);
+        _pidfds[pidfd.getFd()].reset();
+        _running--;
+        spawn();
+    }
+
+    bool done() const { return _remaining == 0 && _running == 0; }
+
+private:
+    EventManager&                                     _events;
+    u32                                               _remaining;
+    u32                                               _running;
+    std::vector<std::unique_ptr<ipc::FileDescriptor>> _pidfds;
+};
+
+static double measure(EventManager::Backend backend, u32 total, u32 concurrency)
+{
+    EventManager events(backend);
+    Churn        churn(events, total);
+
+    auto start = Clock::now();
+
+    for (u32 i = 0; i < concurrency; i++)
+        churn.spawn();
+    while (!churn.done())
+        events.handleEvents();
+
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    std::cout << events.getBackendName() << ": " << total / elapsed.count() << " processes/s\n";
+    return elapsed.count();
+}
+
+int main(int argc, char** argv)
+{
+    u32 total       = argc > 1 ? std::stoul(argv[1]) : 5000;
+    u32 concurrency = argc > 2 ? std::stoul(argv[2]) : 64;
+
+    Logger::LogInterface::Initialize("bench_process_churn", Logger::LogLevel::Sparse, true);
+
+    std::cout << "processes: " << total << ", in flight: " << concurrency << "\n";
+    measure(EventManager::Backend::EPOLL, total, concurrency);
+    measure(EventManager::Backend::IO_URING, total, concurrency);
+
+    return 0;
+}
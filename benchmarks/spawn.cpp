@@ -0,0 +1,94 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include <taskmasterd/include/jobs/Spawner.hpp>
+#include <utils/include/utils.hpp>
+
+/**
+ * Measures spawns per second of the previous fork + pidfd_open path against the Spawner. The
+ * daemon is emulated by a touched heap ballast, fork has to copy its page tables on every spawn
+ * while the Spawner shares them with the child until execve.
+ */
+
+using Clock = std::chrono::steady_clock;
+using taskmasterd::SpawnRequest;
+using taskmasterd::SpawnResult;
+using taskmasterd::Spawner;
+
+static char* const ARGV[] = {const_cast<char*>("/bin/true"), nullptr};
+
+static void reap(pid_t pid, i32 pidfd)
+{
+    i32 status;
+
+    if (waitpid(pid, &status, 0) == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        throw std::runtime_error("Spawned process did not exit cleanly");
+    close(pidfd);
+}
+
+static void spawnFork()
+{
+    pid_t pid = fork();
+    if (pid == -1)
+        throw std::runtime_error("Fork failed: " + std::string(strerror(errno)));
+    if (pid == 0) {
+        // the previous child built its arguments and log lines on the heap before execve
+        std::string path = ARGV[0];
+
+        setpgid(0, 0);
+        umask(022);
+        execve(path.c_str(), ARGV, environ);
+        _exit(EXIT_FAILURE);
+    }
+
+    i32 pidfd = syscall(SYS_pidfd_open, pid, 0);
+    if (pidfd == -1)
+        throw std::runtime_error("Failed to open pidfd: " + std::string(strerror(errno)));
+    reap(pid, pidfd);
+}
+
+static void spawnClone()
+{
+    SpawnRequest request{ARGV[0], ARGV, environ, "/", 0, 022};
+    SpawnResult  result = Spawner::getInstance().spawn(request);
+
+    if (result.error != 0)
+        throw std::runtime_error(std::string(result.failed_step) + ": " + strerror(result.error));
+    reap(result.pid, result.pidfd);
+}
+
+static void measure(const char* name, void (*spawn)(), u32 total)
+{
+    auto start = Clock::now();
+
+    for (u32 i = 0; i < total; i++)
+        spawn();
+
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    std::cout << name << ": " << total / elapsed.count() << " spawns/s\n";
+}
+
+int main(int argc, char** argv)
+{
+    u32   total       = argc > 1 ? std::stoul(argv[1]) : 2000;
+    usize ballast_mib = argc > 2 ? std::stoul(argv[2]) : 1024;
+
+    // touch every page so it is mapped and has to be copied by fork
+    std::vector<char> ballast(ballast_mib * 1024 * 1024);
+    for (usize i = 0; i < ballast.size(); i += 4096)
+        ballast[i] = 1;
+
+    std::cout << "spawns: " << total << ", resident ballast: " << ballast_mib << " MiB\n";
+    measure("fork + pidfd_open", spawnFork, total);
+    measure("clone(CLONE_VM | CLONE_VFORK | CLONE_PIDFD)", spawnClone, total);
+
+    return 0;
+}
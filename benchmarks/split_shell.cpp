@@ -0,0 +1,92 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <wordexp.h>
+
+#include <utils/include/utils.hpp>
+
+/**
+ * Splits a large set of generated commands with wordexp(3), which split_shell used to call, and
+ * with the in-process lexer, and checks that both produce the same arguments. The corpus has line
+ * continuations, like the commands of a multi-line 'cmd:' in YAML.
+ */
+
+using Clock = std::chrono::steady_clock;
+
+static std::vector<std::string> wordexpSplit(const std::string& str)
+{
+    wordexp_t                p;
+    std::vector<std::string> result;
+
+    if (wordexp(str.c_str(), &p, 0) == 0) {
+        for (usize i = 0; i < p.we_wordc; i++)
+            result.emplace_back(p.we_wordv[i]);
+        wordfree(&p);
+    }
+    return result;
+}
+
+static std::vector<std::string> generate(u32 count)
+{
+    static const char* words[] = {"/usr/bin/python3", "-m",          "http.server",          "--bind=127.0.0.1", "'single quoted words'",
+                                  "\"double $BENCH_VAR\"", "escaped\\ space", "${BENCH_VAR}/suffix", "$BENCH_PORT",       "~/data",
+                                  "\"\"",                 "'it'\\''s'",    "--name=\"a b\"",       "-v",               "42",
+                                  "\\\n  --flag",       "con\\\ntinued"};
+    std::mt19937             random(42);
+    std::vector<std::string> commands;
+
+    commands.reserve(count);
+    for (u32 i = 0; i < count; i++) {
+        std::string command = words[0];
+        u32         length  = 2 + random() % 10;
+
+        for (u32 j = 0; j < length; j++) {
+            command += ' ';
+            command += words[random() % std::size(words)];
+        }
+        commands.push_back(std::move(command));
+    }
+    return commands;
+}
+
+template <typename Split> static double run(const std::vector<std::string>& commands, std::vector<std::vector<std::string>>& results, Split split)
+{
+    auto start = Clock::now();
+
+    for (usize i = 0; i < commands.size(); i++)
+        results[i] = split(commands[i]);
+
+    std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+    return elapsed.count();
+}
+
+int main(int argc, char** argv)
+{
+    u32 count = argc > 1 ? std::stoul(argv[1]) : 10000;
+
+    setenv("BENCH_VAR", "/srv/app", 1);
+    setenv("BENCH_PORT", "8080", 1);
+
+    std::vector<std::string>              commands = generate(count);
+    std::vector<std::vector<std::string>> expected(count);
+    std::vector<std::vector<std::string>> results(count);
+    VariableLookup                        lookup = [](std::string_view name) { return std::getenv(std::string(name).c_str()); };
+
+    double wordexp_ms = run(commands, expected, wordexpSplit);
+    double lexer_ms   = run(commands, results, [&lookup](const std::string& command) { return split_shell(command, lookup); });
+
+    usize mismatches = 0;
+    for (u32 i = 0; i < count; i++) {
+        if (results[i] != expected[i] && mismatches++ == 0)
+            std::cout << "mismatch: " << commands[i] << "\n";
+    }
+
+    std::cout << "commands: " << count << "\n"
+              << "wordexp: " << wordexp_ms << " ms\n"
+              << "split_shell: " << lexer_ms << " ms (" << wordexp_ms / lexer_ms << "x)\n"
+              << "mismatches: " << mismatches << "\n";
+    return mismatches == 0 ? 0 : 1;
+}
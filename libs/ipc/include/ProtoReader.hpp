@@ -38,33 +38,48 @@ public:
         if (bytes_read > 0) {
             // Append the newly read data to the internal buffer
             _buffer.insert(_buffer.end(), buffer, buffer + bytes_read);
-            if (!_message_size.has_value() && _buffer.size() >= sizeof(i32)) {
-                // Read the size of the message (first 4 bytes)
-                i32 message_size;
-                std::memcpy(&message_size, _buffer.data(), sizeof(i32));
-                _message_size = ntohl(message_size);
-                LOG_DEBUG("Successfully received a message size of: " + std::to_string(_message_size.value()) + " bytes");
-            }
 
-            if (_message_size.has_value() && _buffer.size() >= sizeof(i32) + _message_size.value()) {
-                // We have a complete message
-                T    message;
-                bool success = message.ParseFromArray(_buffer.data() + sizeof(i32), _message_size.value());
+            return {bytes_read, this->next()};
+        } else if (bytes_read == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            throw std::runtime_error("Failed to read from fd: " + std::string(strerror(errno)));
+        }
 
-                _buffer.erase(_buffer.begin(), _buffer.begin() + sizeof(i32) + _message_size.value());
-                _message_size.reset();
+        return {bytes_read, std::nullopt};
+    }
 
-                if (!success) {
-                    throw std::runtime_error("Failed to parse protobuf message");
-                }
+    /**
+     * @brief Parse a message that was received completely already, without reading.
+     *
+     * A single read can receive more than one message, the ones after the first are returned by
+     * this method before anything new is read.
+     *
+     * @return The parsed message or std::nullopt if no complete message is buffered.
+     */
+    std::optional<T> next()
+    {
+        if (!_message_size.has_value() && _buffer.size() >= sizeof(i32)) {
+            // Read the size of the message (first 4 bytes)
+            i32 message_size;
+            std::memcpy(&message_size, _buffer.data(), sizeof(i32));
+            _message_size = ntohl(message_size);
+            LOG_DEBUG("Successfully received a message size of: " + std::to_string(_message_size.value()) + " bytes");
+        }
 
-                return {bytes_read, message};
-            }
-        } else if (bytes_read == -1 && errno != EAGAIN && errno != EWOULDBLOCK) {
-            throw std::runtime_error("Failed to read from fd: " + std::string(strerror(errno)));
+        if (!_message_size.has_value() || _buffer.size() < sizeof(i32) + _message_size.value())
+            return std::nullopt;
+
+        // We have a complete message
+        T    message;
+        bool success = message.ParseFromArray(_buffer.data() + sizeof(i32), _message_size.value());
+
+        _buffer.erase(_buffer.begin(), _buffer.begin() + sizeof(i32) + _message_size.value());
+        _message_size.reset();
+
+        if (!success) {
+            throw std::runtime_error("Failed to parse protobuf message");
         }
 
-        return {bytes_read, std::nullopt};
+        return message;
     }
 
 private:
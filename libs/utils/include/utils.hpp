@@ -1,8 +1,10 @@
 #pragma once
 
+#include <functional>
 #include <signal.h>
 #include <stdint.h>
 #include <string>
+#include <string_view>
 #include <sys/types.h>
 #include <vector>
 
@@ -39,12 +41,25 @@ i32 pidfd_send_signal(i32 pidfd, i32 sig, const siginfo_t* info, u32 flags);
 i32 pidfd_open(pid_t pid, u32 flags);
 
 /**
- * @brief Split a command line string into arguments, respecting shell-like quoting.
+ * @brief Look up the value of a variable, returns nullptr when it is not set.
+ */
+using VariableLookup = std::function<const char*(std::string_view name)>;
+
+/**
+ * @brief Split a command line string into arguments the way a POSIX shell does, without running a shell.
+ *
+ * Words are separated by blanks. Single quotes keep everything literally, double quotes keep
+ * everything except $ and backslash escapes, and a backslash outside quotes escapes the next
+ * character. A # at the start of a word starts a comment.
  *
- * This function splits the input string into a vector of strings, treating spaces as
- * delimiters but respecting quoted substrings (both single and double quotes).
+ * With a lookup, $NAME and ${NAME} are replaced by the value of the variable, an unset variable
+ * is replaced by nothing, and a leading ~ by $HOME. The values are inserted as they are, they are
+ * not split into words. Without a lookup a $ is kept literally.
  *
  * @param str The input command line string to split.
+ * @param lookup Resolves variables, nullptr disables the expansion.
  * @return std::vector<std::string> A vector of strings representing the split arguments.
+ * @throw std::runtime_error on an unterminated quote, a trailing backslash, or shell syntax that
+ * needs a shell: | & ; < > ( ) ` and $( ).
  */
-std::vector<std::string> split_shell(const std::string& str);
+std::vector<std::string> split_shell(std::string_view str, const VariableLookup& lookup = nullptr);
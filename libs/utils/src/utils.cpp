@@ -1,7 +1,9 @@
 #include <utils.hpp>
 
+#include <cctype>
+#include <stdexcept>
+#include <string.h>
 #include <sys/syscall.h>
-#include <wordexp.h>
 
 i32 pidfd_send_signal(i32 pidfd, i32 sig, const siginfo_t* info, u32 flags)
 {
@@ -13,17 +15,203 @@ i32 pidfd_open(pid_t pid, u32 flags)
     return syscall(SYS_pidfd_open, pid, flags);
 }
 
-std::vector<std::string> split_shell(const std::string& str)
+namespace
 {
-    wordexp_t                p;
-    std::vector<std::string> result;
+/**
+ * @brief Tokenizer behind split_shell, walks the input once and appends to the current word.
+ */
+class ShellLexer
+{
+public:
+    ShellLexer(std::string_view str, const VariableLookup& lookup)
+        : _str(str)
+        , _lookup(lookup)
+        , _pos(0)
+    {
+    }
+
+    std::vector<std::string> split()
+    {
+        std::vector<std::string> words;
+        std::string              word;
+        bool                     in_word = false; // quotes can make an empty word
+
+        while (_pos < _str.size()) {
+            char c = _str[_pos];
+
+            // an escaped newline only continues the line, like sh it neither ends nor starts a word
+            if (c == '\\' && _pos + 1 < _str.size() && _str[_pos + 1] == '\n') {
+                _pos += 2;
+                continue;
+            }
 
-    if (wordexp(str.c_str(), &p, 0) == 0) {
-        for (size_t i = 0; i < p.we_wordc; i++) {
-            result.emplace_back(p.we_wordv[i]);
+            if (c == ' ' || c == '\t' || c == '\n') {
+                if (in_word)
+                    words.push_back(std::move(word));
+                word.clear();
+                in_word = false;
+                _pos++;
+                continue;
+            }
+
+            if (!in_word && c == '#')
+                break;
+
+            if (!in_word && c == '~' && _lookup && (_pos + 1 == _str.size() || strchr("/ \t\n", _str[_pos + 1]) != nullptr)) {
+                appendVariable(word, "HOME");
+                in_word = true;
+                _pos++;
+                continue;
+            }
+
+            in_word = true;
+            switch (c) {
+            case '\\':
+                if (_pos + 1 == _str.size())
+                    throw std::runtime_error("trailing backslash");
+                word += _str[_pos + 1];
+                _pos += 2;
+                break;
+            case '\'': {
+                usize end = _str.find('\'', _pos + 1);
+                if (end == std::string_view::npos)
+                    throw std::runtime_error("unterminated single quote");
+                word.append(_str.substr(_pos + 1, end - _pos - 1));
+                _pos = end + 1;
+                break;
+            }
+            case '"':
+                _pos++;
+                doubleQuoted(word);
+                break;
+            case '$':
+                dollar(word);
+                break;
+            case '|':
+            case '&':
+            case ';':
+            case '<':
+            case '>':
+            case '(':
+            case ')':
+            case '`':
+                throw std::runtime_error(std::string("unsupported shell syntax '") + c + "', use sh -c to run a shell");
+            default:
+                word += c;
+                _pos++;
+            }
         }
-        wordfree(&p);
+
+        if (in_word)
+            words.push_back(std::move(word));
+
+        return words;
     }
 
-    return result;
+private:
+    /**
+     * @brief Read the rest of a double quoted string, the opening quote is already consumed.
+     */
+    void doubleQuoted(std::string& word)
+    {
+        while (true) {
+            if (_pos == _str.size())
+                throw std::runtime_error("unterminated double quote");
+
+            char c = _str[_pos];
+            if (c == '"') {
+                _pos++;
+                return;
+            }
+            if (c == '\\' && _pos + 1 < _str.size() && strchr("$`\"\\\n", _str[_pos + 1]) != nullptr) {
+                if (_str[_pos + 1] != '\n')
+                    word += _str[_pos + 1];
+                _pos += 2;
+            } else if (c == '$') {
+                dollar(word);
+            } else if (c == '`') {
+                throw std::runtime_error("unsupported command substitution, use sh -c to run a shell");
+            } else {
+                word += c;
+                _pos++;
+            }
+        }
+    }
+
+    /**
+     * @brief Expand the variable that starts at the $ under the cursor.
+     */
+    void dollar(std::string& word)
+    {
+        usize start = _pos + 1;
+
+        if (start < _str.size() && _str[start] == '(')
+            throw std::runtime_error("unsupported command substitution, use sh -c to run a shell");
+
+        if (!_lookup) {
+            word += '$';
+            _pos++;
+            return;
+        }
+
+        if (start < _str.size() && _str[start] == '{') {
+            usize end = _str.find('}', start + 1);
+            if (end == std::string_view::npos)
+                throw std::runtime_error("unterminated ${");
+
+            std::string_view name = _str.substr(start + 1, end - start - 1);
+            if (!isName(name))
+                throw std::runtime_error("invalid variable name '" + std::string(name) + "'");
+
+            appendVariable(word, name);
+            _pos = end + 1;
+            return;
+        }
+
+        usize end = start;
+        while (end < _str.size() && isNameChar(_str[end], end == start))
+            end++;
+
+        // a $ that does not start a name is kept
+        if (end == start) {
+            word += '$';
+            _pos++;
+            return;
+        }
+
+        appendVariable(word, _str.substr(start, end - start));
+        _pos = end;
+    }
+
+    void appendVariable(std::string& word, std::string_view name)
+    {
+        const char* value = _lookup(name);
+
+        if (value != nullptr)
+            word += value;
+    }
+
+    static bool isNameChar(char c, bool first)
+    {
+        return c == '_' || isalpha(static_cast<unsigned char>(c)) || (!first && isdigit(static_cast<unsigned char>(c)));
+    }
+
+    static bool isName(std::string_view name)
+    {
+        for (usize i = 0; i < name.size(); i++) {
+            if (!isNameChar(name[i], i == 0))
+                return false;
+        }
+        return !name.empty();
+    }
+
+    std::string_view      _str;
+    const VariableLookup& _lookup;
+    usize                 _pos;
+};
+} // namespace
+
+std::vector<std::string> split_shell(std::string_view str, const VariableLookup& lookup)
+{
+    return ShellLexer(str, lookup).split();
 }
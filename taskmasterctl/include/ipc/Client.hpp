@@ -11,6 +11,8 @@ ipc::Socket connectToDaemon();
 void sendCommandToDaemon(ipc::Socket& socket, proto::Command& command);
 
 /**
+ * @brief Print the response to a command, the output of 'tail -f' is printed until Ctrl-C.
+ *
  * @return True if ctl should exit after the received response
  */
 bool awaitDaemonResponse(ipc::Socket& socket, proto::Command& command);
@@ -7,6 +7,7 @@
 
 #include <iostream>
 #include <optional>
+#include <utility>
 
 #ifndef PROGRAM_NAME
 #define PROGRAM_NAME "taskmasterctl"
@@ -33,6 +34,9 @@ static void parseCommandArgs(std::string& input, proto::Command& command)
 
     while (!input.empty()) {
         commandArg = getToken(input);
+        // the daemon takes options with a value as one argument, "--since 5m" becomes "--since=5m"
+        if (commandArg == "--since" && !input.empty())
+            commandArg += "=" + getToken(input);
         command.add_args(commandArg);
         LOG_DEBUG(commandArg + ": Added as argument")
     }
@@ -51,18 +55,28 @@ static std::string toLower(std::string&& input)
 
 static bool parseCommandType(std::string& input, proto::Command& command)
 {
-    const char* validTypes[] = {"start", "stop", "restart", "status", "reload", "terminate"};
-    std::string commandType  = toLower(getToken(input));
-
-    for (size_t i = 0; i < (sizeof(validTypes) / sizeof(const char*)); i++) {
-        if (commandType == validTypes[i]) {
+    // the command types are not contiguous, COMMAND_ERROR sits between terminate and tail
+    const std::pair<const char*, proto::CommandType> validTypes[] = {
+        {"start", proto::CommandType::START},
+        {"stop", proto::CommandType::STOP},
+        {"restart", proto::CommandType::RESTART},
+        {"status", proto::CommandType::STATUS},
+        {"reload", proto::CommandType::RELOAD},
+        {"terminate", proto::CommandType::TERMINATE},
+        {"tail", proto::CommandType::TAIL},
+        {"logs", proto::CommandType::LOGS},
+    };
+    std::string commandType = toLower(getToken(input));
+
+    for (const auto& [name, type] : validTypes) {
+        if (commandType == name) {
             LOG_DEBUG(commandType + ": Added as command type")
-            command.set_type(static_cast<proto::CommandType>(i));
+            command.set_type(type);
             return true;
         }
     }
 
-    LOG_WARNING("Invalid command: " + std::string(commandType) + " - Valid commands: start, stop, restart, status, reload, terminate")
+    LOG_WARNING("Invalid command: " + std::string(commandType) + " - Valid commands: start, stop, restart, status, reload, terminate, tail, logs")
     return false;
 }
 
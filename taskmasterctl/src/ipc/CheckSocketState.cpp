@@ -1,6 +1,7 @@
 #include <taskmasterctl/include/ipc/CheckSocketState.hpp>
 #include <ipc/include/Socket.hpp>
 #include <logger/include/Logger.hpp>
+#include <csignal>
 #include <sys/epoll.h>
 #include <unistd.h>
 
@@ -15,6 +16,12 @@ void checkSocketState(const ipc::Socket& socket)
     struct epoll_event events[MAX_EVENTS];
     struct epoll_event event;
     auto               epollFd = epoll_create1(0);
+    sigset_t           interrupt;
+
+    // Ctrl-C is left to the main thread, it ends the output of 'tail -f' instead of the program
+    sigemptyset(&interrupt);
+    sigaddset(&interrupt, SIGINT);
+    pthread_sigmask(SIG_BLOCK, &interrupt, nullptr);
 
     if (epollFd == -1) {
         throw std::runtime_error("Failed to create the epoll file descriptor: " + std::string(strerror(errno)));
@@ -41,13 +48,13 @@ void checkSocketState(const ipc::Socket& socket)
             if (events[i].events & EPOLLHUP) {
                 LOG_INFO("\nDeamon has closed the socket");
 
-                // Raise a SIGINT so the main thread gets interupted
+                // Send a SIGINT to the process so the main thread gets interupted, this thread blocks it
 
                 // If a terminate command has been sent then the main thread is already waiting
                 // for this thread to end, no need to raise a signal as this will set an error exit code
                 // and prevent proper cleanup of resources.
                 if (g_exitChecker == false) 
-                    raise(SIGINT);
+                    kill(getpid(), SIGINT);
                 return ;
             }
         }
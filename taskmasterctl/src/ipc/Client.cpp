@@ -6,8 +6,14 @@
 
 #include <proto/taskmaster.pb.h>
 
+#include <csignal>
+#include <poll.h>
+
 #define SOCKET_PATH "/tmp/taskmasterd.sock"
 
+// how long a stream waits for output before it checks for Ctrl-C again, in milliseconds
+#define STREAM_POLL_TIMEOUT 200
+
 namespace taskmasterctl
 {
 
@@ -40,6 +46,78 @@ void sendCommandToDaemon(ipc::Socket& socket, proto::Command& command)
 
 using ResponseReader       = ipc::ProtoReader<proto::CommandResponse>;
 using ResponseReaderReturn = std::pair<isize, std::optional<proto::CommandResponse>>;
+
+static volatile sig_atomic_t g_interrupted = 0;
+
+static void onInterrupt(int signal)
+{
+    (void)signal;
+    g_interrupted = 1;
+}
+
+static void printOutput(const proto::CommandResponse& response)
+{
+    if (response.message().size() != 0)
+        std::cout << response.message() << std::endl;
+    // the output of the processes is printed as is, it ends with their last newline
+    if (response.output().size() != 0)
+        std::cout.write(response.output().data(), response.output().size()).flush();
+}
+
+/**
+ * @brief Print the messages of a stream until it ends, Ctrl-C asks the daemon to end it.
+ */
+static void followDaemonStream(ipc::Socket& socket, ResponseReader& protoReader)
+{
+    struct sigaction interrupt = {};
+    struct sigaction previous;
+
+    // without SA_RESTART the poll returns right away on Ctrl-C
+    interrupt.sa_handler = onInterrupt;
+    sigemptyset(&interrupt.sa_mask);
+    sigaction(SIGINT, &interrupt, &previous);
+    g_interrupted = 0;
+
+    try {
+        bool stopping = false;
+
+        while (true) {
+            // any command ends the stream, the daemon answers it with the last message of the stream
+            if (g_interrupted && !stopping) {
+                proto::Command stop;
+
+                stop.set_type(proto::CommandType::TAIL);
+                sendCommandToDaemon(socket, stop);
+                stopping = true;
+            }
+
+            std::optional<proto::CommandResponse> response = protoReader.next();
+            if (!response.has_value()) {
+                struct pollfd pollFd = {socket.getFd(), POLLIN, 0};
+
+                if (poll(&pollFd, 1, STREAM_POLL_TIMEOUT) <= 0)
+                    continue;
+
+                ResponseReaderReturn res = protoReader.read(socket);
+                if (res.first == 0)
+                    throw std::runtime_error("The daemon closed the connection");
+                if (!res.second.has_value())
+                    continue;
+                response = std::move(res.second);
+            }
+
+            printOutput(response.value());
+            if (!response->streaming())
+                break;
+        }
+    } catch (...) {
+        sigaction(SIGINT, &previous, nullptr);
+        throw;
+    }
+
+    sigaction(SIGINT, &previous, nullptr);
+}
+
 bool awaitDaemonResponse(ipc::Socket& socket, proto::Command& command)
 {
     ResponseReaderReturn res = ResponseReaderReturn(0, std::nullopt);
@@ -52,8 +130,9 @@ bool awaitDaemonResponse(ipc::Socket& socket, proto::Command& command)
 
     switch (response.status()) {
     case proto::CommandStatus::OK:
-        if (response.message().size() != 0)
-            std::cout << response.message() << std::endl;
+        printOutput(response);
+        if (response.streaming())
+            followDaemonStream(socket, protoReader);
         if (command.type() == proto::CommandType::TERMINATE)
             return true;
         return false;
@@ -13,7 +13,7 @@
 #define PROGRAM_NAME "taskmasterctl"
 #endif
 
-const char* commands[] = {"start", "stop", "restart", "status", "reload", "terminate", NULL};
+const char* commands[] = {"start", "stop", "restart", "status", "reload", "terminate", "tail", "logs", NULL};
 
 static char* completer_generator(const char* text, int state)
 {
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <sys/epoll.h>
+#include <vector>
+
+#include <taskmasterd/include/core/EventBackend.hpp>
+
+namespace taskmasterd
+{
+class EpollBackend : public EventBackend
+{
+public:
+    /**
+     * @brief Construct a new EpollBackend object.
+     *
+     * Initializes the epoll instance for event monitoring.
+     */
+    EpollBackend();
+
+    void add(i32 fd, u32 events, u64 data) override;
+    void modify(i32 fd, u32 events, u64 data) override;
+    void remove(i32 fd) override;
+    i32  wait(Event* events, i32 max_events) override;
+
+    const char* name() const override { return "epoll"; }
+
+private:
+    void control(i32 fd, i32 operation, u32 events, u64 data);
+
+    std::vector<struct epoll_event> _events;
+};
+} // namespace taskmasterd
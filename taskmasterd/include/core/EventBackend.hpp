@@ -0,0 +1,68 @@
+#pragma once
+
+#include <ipc/include/FileDescriptor.hpp>
+#include <utils/include/utils.hpp>
+
+namespace taskmasterd
+{
+/**
+ * @brief The kernel interface the EventManager waits on for readiness of its file descriptors.
+ *
+ * Backends have level triggered semantics: as long as a registered file descriptor is ready,
+ * every call to wait reports it again.
+ */
+class EventBackend : public ipc::FileDescriptor
+{
+public:
+    enum Interest : u32
+    {
+        READ  = 1 << 0,
+        WRITE = 1 << 1,
+    };
+
+    struct Event
+    {
+        u64 data;   // the data the file descriptor was registered with
+        u32 events; // the Interest flags that are ready
+    };
+
+    EventBackend(i32 fd)
+        : FileDescriptor(fd)
+    {
+    }
+    virtual ~EventBackend() = default;
+
+    /**
+     * @brief Start monitoring a file descriptor.
+     *
+     * @param fd The file descriptor to monitor.
+     * @param events The Interest flags to monitor.
+     * @param data Opaque data that is returned with every event of this registration.
+     */
+    virtual void add(i32 fd, u32 events, u64 data) = 0;
+
+    /**
+     * @brief Change the interest and data of a monitored file descriptor.
+     */
+    virtual void modify(i32 fd, u32 events, u64 data) = 0;
+
+    /**
+     * @brief Stop monitoring a file descriptor.
+     */
+    virtual void remove(i32 fd) = 0;
+
+    /**
+     * @brief Block until at least one event is ready.
+     *
+     * @param events The array to store the ready events in.
+     * @param max_events The size of the events array.
+     * @return The amount of events stored, 0 when interrupted by a signal.
+     */
+    virtual i32 wait(Event* events, i32 max_events) = 0;
+
+    /**
+     * @brief The name of the backend, used for logging.
+     */
+    virtual const char* name() const = 0;
+};
+} // namespace taskmasterd
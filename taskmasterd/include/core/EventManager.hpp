@@ -1,24 +1,35 @@
 #pragma once
 
+#include <deque>
 #include <functional>
+#include <memory>
 
 #include <ipc/include/FileDescriptor.hpp>
+#include <taskmasterd/include/core/EventBackend.hpp>
 #include <utils/include/utils.hpp>
 
 namespace taskmasterd
 {
-class EventManager : public ipc::FileDescriptor
+class EventManager
 {
 public:
     using EventCallback = std::function<void()>;
 
+    enum class Backend
+    {
+        EPOLL,
+        IO_URING,
+    };
+
     /**
      * @brief Construct a new EventManager object.
      *
-     * Initializes the epoll instance for event monitoring.
+     * Initializes the backend instance for event monitoring. When io_uring is requested but not
+     * supported by the build or the kernel, the EventManager falls back to epoll.
      *
+     * @param backend The kernel interface to wait for events with.
      */
-    EventManager();
+    EventManager(Backend backend = getDefaultBackend());
 
     /**
      * @brief Register an event handler for a file descriptor.
@@ -27,7 +38,7 @@ public:
      * @param read_callback The callback function to invoke on read events.
      * @param write_callback The callback function to invoke on write events.
      */
-    void registerEvent(const FileDescriptor& handler, EventCallback read_callback = nullptr, EventCallback write_callback = nullptr);
+    void registerEvent(const ipc::FileDescriptor& handler, EventCallback read_callback = nullptr, EventCallback write_callback = nullptr);
 
     /**
      * @brief Update the event handler for a file descriptor.
@@ -35,7 +46,7 @@ public:
      * @param read_callback The new callback function for read events.
      * @param write_callback The new callback function for write events.
      */
-    void updateEvent(const FileDescriptor& handler, EventCallback read_callback, EventCallback write_callback);
+    void updateEvent(const ipc::FileDescriptor& handler, EventCallback read_callback, EventCallback write_callback);
 
     /**
      * @brief Unregister an event handler for a file descriptor.
@@ -60,14 +71,50 @@ public:
      */
     static EventManager& getInstance();
 
+    /**
+     * @brief Get the backend selected by the TASKMASTERD_EVENT_BACKEND environment variable ("epoll" or "io_uring").
+     *
+     * Defaults to io_uring when it is built in, epoll otherwise.
+     */
+    static Backend getDefaultBackend();
+
+    /**
+     * @brief Get the name of the backend in use.
+     */
+    const char* getBackendName() const { return _backend->name(); }
+
 private:
-    using EventCallbackMap = std::unordered_map<i32, EventCallback>;
+    /**
+     * @brief A slot in the handler table, one per file descriptor number.
+     *
+     * The generation is bumped on every (un)registration and is stored in the epoll event data
+     * together with the fd. Events that were already returned by epoll_wait for a previous
+     * registration of the same fd number are therefore skipped instead of calling the new handler.
+     */
+    struct Handler
+    {
+        EventCallback read_callback;
+        EventCallback write_callback;
+        u32           generation = 0;
+    };
+
+    void updateEventInternal(const ipc::FileDescriptor& handler, bool add, EventCallback read_callback, EventCallback write_callback);
 
-    void updateEventInternal(const FileDescriptor& handler, i32 operation, EventCallback read_callback, EventCallback write_callback);
+    /**
+     * @brief Get the handler slot of a file descriptor, growing the table when needed.
+     */
+    Handler& getHandler(i32 fd);
+
+    /**
+     * @brief Check if an event still belongs to the current registration of its fd.
+     */
+    bool isCurrent(i32 fd, u32 generation) const { return static_cast<usize>(fd) < _handlers.size() && _handlers[fd].generation == generation; }
 
     const static i32 MAX_EVENTS = 1024;
 
-    EventCallbackMap _read_callbacks;
-    EventCallbackMap _write_callbacks;
+    std::unique_ptr<EventBackend> _backend;
+
+    // A deque keeps references stable when the table grows from within a callback
+    std::deque<Handler> _handlers;
 };
 } // namespace taskmasterd
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include <utils/include/utils.hpp>
+
+namespace taskmasterd
+{
+/**
+ * @brief 64 bit FNV-1a hash, every value is prefixed with its size so "ab","c" and "a","bc" differ.
+ *
+ * The result only depends on the added bytes, it is stable across runs and can be stored on disk.
+ */
+class Hasher
+{
+public:
+    void add(const void* data, usize size)
+    {
+        const u8* bytes = static_cast<const u8*>(data);
+
+        for (usize i = 0; i < size; i++) {
+            _hash ^= bytes[i];
+            _hash *= 0x100000001b3;
+        }
+    }
+
+    void add(std::string_view value)
+    {
+        add(value.size());
+        add(value.data(), value.size());
+    }
+
+    void add(const std::string& value) { add(std::string_view(value)); }
+
+    void add(const std::optional<std::string>& value)
+    {
+        add(value.has_value());
+        if (value.has_value())
+            add(value.value());
+    }
+
+    template <typename T> void add(const T& value)
+        requires std::is_arithmetic_v<T> || std::is_enum_v<T>
+    {
+        add(&value, sizeof(value));
+    }
+
+    u64 get() const { return _hash; }
+
+private:
+    u64 _hash = 0xcbf29ce484222325;
+};
+} // namespace taskmasterd
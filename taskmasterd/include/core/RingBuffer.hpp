@@ -0,0 +1,82 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <utils/include/utils.hpp>
+
+namespace taskmasterd
+{
+/**
+ * @brief Keeps the last 'capacity' bytes written to it, older bytes are overwritten.
+ *
+ * The memory grows in powers of two up to the capacity as bytes are written, a quiet process does
+ * not pay for the full buffer. Every byte has an offset, the amount of bytes written before it.
+ */
+class RingBuffer
+{
+public:
+    /**
+     * @brief Construct a new RingBuffer object.
+     *
+     * @param capacity The amount of bytes kept, rounded up to a power of two.
+     */
+    explicit RingBuffer(usize capacity);
+
+    RingBuffer(const RingBuffer&)            = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    /**
+     * @brief Append bytes, the oldest bytes are dropped once the buffer is full.
+     */
+    void write(const char* data, usize size);
+
+    /**
+     * @brief Account for bytes that were dropped before they reached the buffer.
+     *
+     * The bytes that are kept end where the dropped bytes start, offsets stay those of the stream.
+     */
+    void skip(u64 size);
+
+    /**
+     * @brief Get the last bytes that were written.
+     *
+     * @param size The amount of bytes, at most the amount that is kept.
+     */
+    std::string tail(usize size) const;
+
+    /**
+     * @brief Get the bytes from an offset up to the end, bytes that were dropped already are skipped.
+     */
+    std::string readFrom(u64 offset) const;
+
+    /**
+     * @brief Get the amount of bytes that are kept.
+     */
+    usize getSize() const { return _written - _start < _capacity ? _written - _start : _capacity; }
+
+    usize getCapacity() const { return _capacity; }
+
+    /**
+     * @brief Get the amount of bytes written since the buffer was created, the offset of the next byte.
+     */
+    u64 getWritten() const { return _written; }
+
+private:
+    /**
+     * @brief Make room for size more bytes while the buffer did not reach its capacity yet.
+     */
+    void grow(usize size);
+
+    /**
+     * @brief Copy bytes to the place of an offset, wrapping around the end of the memory.
+     */
+    void store(u64 offset, const char* data, usize size);
+
+    std::unique_ptr<char[]> _data;
+    usize                   _allocated;
+    usize                   _capacity;
+    u64                     _written;
+    u64                     _start; // the offset after the last skipped bytes, nothing before it is kept
+};
+} // namespace taskmasterd
@@ -2,12 +2,12 @@
 
 #include <functional>
 
-#include <ipc/include/FileDescriptor.hpp>
+#include <taskmasterd/include/core/TimerWheel.hpp>
 #include <utils/include/utils.hpp>
 
 namespace taskmasterd
 {
-class Timer : public ipc::FileDescriptor
+class Timer : private TimerWheel::Link
 {
 public:
     enum class State
@@ -23,27 +23,47 @@ public:
      * @param callback The callback function to be called when the timer expires.
      */
     Timer(i32 interval, std::function<void()> callback);
+
+    /**
+     * @brief Construct a new Timer object.
+     *
+     * @param interval The timer interval.
+     * @param callback The callback function to be called when the timer expires.
+     */
+    Timer(TimerWheel::Duration interval, std::function<void()> callback);
     virtual ~Timer();
 
+    Timer(const Timer&)            = delete;
+    Timer& operator=(const Timer&) = delete;
+
     /**
      * @brief Start the timer.
      *
-     * This method sets the timer to expire after the specified interval
-     * and registers it with the EventManager to handle read events.
+     * This method schedules the timer on the TimerWheel to expire after the specified interval.
+     * Starting a running timer restarts its interval.
      */
     void start();
 
+    /**
+     * @brief Stop the timer without calling the callback.
+     */
+    void stop();
+
     /**
      * @brief Callback function for timer expiration.
      *
-     * This method is called when the timer expires. It reads the expiration count
-     * from the timer file descriptor and invokes the callback function.
+     * This method is called by the TimerWheel when the timer expires and invokes the callback function.
      */
     void onExpire();
 
+    State getState() const { return _state; }
+
 private:
-    i32   _interval;
-    State _state;
+    friend TimerWheel;
+
+    TimerWheel::Duration _interval;
+    State                _state;
+    u64                  _expiry;
 
     std::function<void()> _callback;
 };
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <chrono>
+
+#include <ipc/include/FileDescriptor.hpp>
+#include <utils/include/utils.hpp>
+
+namespace taskmasterd
+{
+class Timer;
+class TimerWheel : public ipc::FileDescriptor
+{
+public:
+    using Duration = std::chrono::milliseconds;
+
+    /**
+     * @brief Intrusive list node, every Timer is linked into exactly one wheel slot while it runs.
+     *
+     * The lists are circular with a sentinel node per slot so a timer can unlink itself in O(1)
+     * without knowing which slot it belongs to.
+     */
+    struct Link
+    {
+        Link() = default;
+        ~Link() { unlink(); }
+
+        Link(const Link&)            = delete;
+        Link& operator=(const Link&) = delete;
+
+        Link* prev = this;
+        Link* next = this;
+
+        bool linked() const { return next != this; }
+        void unlink();
+        void pushBack(Link& node);
+    };
+
+    /**
+     * @brief Construct a new TimerWheel object.
+     *
+     * Creates the single timerfd that drives the wheel and registers it with the EventManager. The
+     * timerfd is armed once for the next tick that has work, the wheel does not tick while idle.
+     */
+    TimerWheel();
+    virtual ~TimerWheel();
+
+    /**
+     * @brief Schedule a timer to expire after the given delay.
+     *
+     * @param timer The timer to schedule, it must not be scheduled already.
+     * @param delay The time from now after which the timer expires, rounded up to the next tick.
+     */
+    void schedule(Timer& timer, Duration delay);
+
+    /**
+     * @brief Remove a scheduled timer from the wheel without calling it.
+     *
+     * @param timer The timer to cancel.
+     */
+    void cancel(Timer& timer);
+
+    /**
+     * @brief Callback for the timerfd, advances the wheel to the current tick and arms the timerfd for the next one with work.
+     */
+    void onTick();
+
+    /**
+     * @brief Get the singleton instance of TimerWheel.
+     *
+     * @return The singleton instance.
+     */
+    static TimerWheel& getInstance();
+
+    static constexpr Duration TICK = Duration(10);
+
+private:
+    static constexpr u32 LEVELS    = 4;
+    static constexpr u32 SLOT_BITS = 8;
+    static constexpr u32 SLOTS     = 1 << SLOT_BITS;
+    static constexpr u32 SLOT_MASK = SLOTS - 1;
+    static constexpr i64 TICK_NS   = std::chrono::duration_cast<std::chrono::nanoseconds>(TICK).count();
+
+    /**
+     * @brief Link a timer into the slot matching its expiry tick relative to the current tick.
+     */
+    void insert(Timer& timer);
+
+    /**
+     * @brief Move every timer of a higher level slot down to the lower levels.
+     */
+    void cascade(u32 level);
+
+    /**
+     * @brief Advance the wheel by a single tick and expire the timers of that tick.
+     */
+    void advance();
+
+    /**
+     * @brief Advance the wheel to a tick, the ticks without expiring or cascading timers are skipped.
+     */
+    void advanceTo(u64 tick);
+
+    /**
+     * @brief Find the next tick that expires or cascades timers, a cascade may come before the expiry it leads to.
+     *
+     * @return The tick, or UINT64_MAX if no timer is pending.
+     */
+    u64 nextEvent() const;
+
+    /**
+     * @brief Get the tick of the monotonic clock now, counted from the creation of the wheel.
+     */
+    u64 getTick() const;
+
+    /**
+     * @brief Arm the timerfd for the start of a tick, 0 disarms it.
+     */
+    void arm(u64 tick);
+
+    Link                                  _slots[LEVELS][SLOTS];
+    std::chrono::steady_clock::time_point _origin; // the start of tick 0
+    u64                                   _current;
+    usize                                 _pending;
+    u64                                   _armed; // the tick the timerfd fires at, 0 while disarmed
+};
+} // namespace taskmasterd
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <linux/io_uring.h>
+#include <vector>
+
+#include <taskmasterd/include/core/EventBackend.hpp>
+
+namespace taskmasterd
+{
+/**
+ * @brief Event backend on top of io_uring poll requests.
+ *
+ * Registrations, modifications and removals are queued as submission entries and handed to the
+ * kernel together with the wait for completions, so a loop iteration costs a single io_uring_enter
+ * no matter how many file descriptors changed.
+ *
+ * Polls are armed one shot and re-armed on the next wait after their handler ran. A new poll
+ * request checks the current readiness of the file, which gives the same level triggered behaviour
+ * as epoll: handlers that only partially drain a socket are called again.
+ */
+class UringBackend : public EventBackend
+{
+public:
+    /**
+     * @brief Construct a new UringBackend object.
+     *
+     * @throw std::runtime_error if the kernel does not support io_uring.
+     */
+    UringBackend();
+    virtual ~UringBackend();
+
+    UringBackend(const UringBackend&)            = delete;
+    UringBackend& operator=(const UringBackend&) = delete;
+
+    void add(i32 fd, u32 events, u64 data) override;
+    void modify(i32 fd, u32 events, u64 data) override;
+    void remove(i32 fd) override;
+    i32  wait(Event* events, i32 max_events) override;
+
+    const char* name() const override { return "io_uring"; }
+
+private:
+    struct Registration
+    {
+        u64  data       = 0;
+        u32  events     = 0;
+        bool registered = false;
+        bool armed      = false; // a poll request is in flight in the kernel
+    };
+
+    /**
+     * @brief Get the registration of a file descriptor, growing the table when needed.
+     */
+    Registration& getRegistration(i32 fd);
+
+    /**
+     * @brief Get the next free submission queue entry, submitting the queue when it is full.
+     */
+    struct io_uring_sqe* getSqe();
+
+    void queuePollAdd(i32 fd, Registration& registration);
+    void queuePollRemove(Registration& registration);
+
+    /**
+     * @brief Hand all queued submissions to the kernel and optionally wait for a completion.
+     *
+     * @return false when the wait was interrupted by a signal.
+     */
+    bool enter(u32 min_complete);
+
+    u32 toEvents(u32 poll_mask, u32 interest) const;
+
+    // user data of entries whose completion is not interesting, such as poll removals
+    static constexpr u64 IGNORED = ~u64(0);
+
+    static constexpr u32 SQ_ENTRIES = 1024;
+    static constexpr u32 CQ_ENTRIES = 4096;
+
+    void* _ring;
+    usize _ring_size;
+
+    struct io_uring_sqe* _sqes;
+    usize                _sqes_size;
+    u32*                 _sq_head;
+    u32*                 _sq_tail;
+    u32*                 _sq_array;
+    u32                  _sq_mask;
+    u32                  _sq_entries;
+
+    u32*                 _cq_head;
+    u32*                 _cq_tail;
+    u32                  _cq_mask;
+    struct io_uring_cqe* _cqes;
+
+    std::vector<Registration> _registrations;
+    std::vector<i32>          _rearm;
+};
+} // namespace taskmasterd
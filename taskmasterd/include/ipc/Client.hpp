@@ -1,9 +1,12 @@
 #pragma once
 
+#include <optional>
+
 #include "proto/taskmaster.pb.h"
 #include <ipc/include/ProtoReader.hpp>
 #include <ipc/include/ProtoWriter.hpp>
 #include <ipc/include/Socket.hpp>
+#include <taskmasterd/include/jobs/OutputFollower.hpp>
 #include <utils/include/utils.hpp>
 
 namespace taskmasterd
@@ -11,6 +14,13 @@ namespace taskmasterd
 
 class Server;
 
+/**
+ * @brief A connected taskmasterctl, it sends one command at a time and waits for the response.
+ *
+ * After 'tail --follow' the response is a stream: the output of the processes is sent as it arrives,
+ * at most one message is in flight and the next one holds everything that arrived in the meantime.
+ * The next command of the client ends the stream, it is answered with the last message of the stream.
+ */
 class Client : ipc::Socket // : public ProtoReader<proto::Command>
 {
 public:
@@ -42,8 +52,34 @@ public:
     bool isConnected() const { return _fd != -1; }
 
 private:
+    /**
+     * @brief Start writing a response, reads are only polled for while following to notice the end of the stream.
+     */
+    void send(proto::CommandResponse& response, const proto::Command& command);
+
+    /**
+     * @brief Send the queued message or the output that arrived since the previous message, if there is any.
+     */
+    void sendNext();
+
+    /**
+     * @brief Called by the follower when there is new output or a followed process is gone.
+     */
+    void onFollowed();
+
+    /**
+     * @brief Stop polling, close the socket and stop following.
+     */
+    void disconnect();
+
     ipc::ProtoReader<proto::Command>         _proto_reader;
     ipc::ProtoWriter<proto::CommandResponse> _proto_writer;
+    bool                                     _writing;
+    bool                                     _streaming;
+
+    OutputFollower                        _follower;
+    proto::Command                        _followed; // the tail command that started the stream
+    std::optional<proto::CommandResponse> _queued;   // a message of the stream without output, sent before the next output
 
     Server& _server;
 };
@@ -39,8 +39,9 @@ public:
      *
      * It is responsible to parse the command and give the result to specific job command through the job manager
      * @param cmd The proto command that the job manager should handle.
+     * @param follower The follower of the client, 'tail --follow' makes it follow the output of the job.
      */
-    proto::CommandResponse onCommand(proto::Command& cmd);
+    proto::CommandResponse onCommand(proto::Command& cmd, OutputFollower& follower);
 
 private:
     /**
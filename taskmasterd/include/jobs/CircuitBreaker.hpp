@@ -0,0 +1,76 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <functional>
+
+#include <taskmasterd/include/core/Timer.hpp>
+#include <taskmasterd/include/jobs/JobConfig.hpp>
+
+namespace taskmasterd
+{
+/**
+ * @brief Stops the automatic restarts of a job that crash loops.
+ *
+ * Every automatic restart is recorded in a sliding window. When more than 'threshold' restarts
+ * happen within 'window' seconds the breaker opens, the job stops restarting its processes until
+ * the breaker closes again after 'cooldown' seconds.
+ */
+class CircuitBreaker
+{
+public:
+    enum class State
+    {
+        CLOSED, // restarts are allowed
+        OPEN    // restarts are refused until the cooldown passed
+    };
+
+    /**
+     * @brief Construct a new CircuitBreaker object.
+     *
+     * @param config The breaker settings of the job.
+     * @param on_close Called when the breaker closes after the cooldown.
+     */
+    CircuitBreaker(const JobConfig::Breaker& config, std::function<void()> on_close);
+
+    CircuitBreaker(const CircuitBreaker&)            = delete;
+    CircuitBreaker& operator=(const CircuitBreaker&) = delete;
+
+    /**
+     * @brief Record an automatic restart.
+     *
+     * @return false if the breaker is open or opened because of this restart.
+     */
+    bool allowRestart();
+
+    /**
+     * @brief Close the breaker without waiting for the cooldown, on_close is not called.
+     */
+    void reset();
+
+    /**
+     * @brief Use new settings, the recorded restarts are kept.
+     */
+    void setConfig(const JobConfig::Breaker& config) { _config = config; }
+
+    State getState() const { return _state; }
+
+    /**
+     * @brief Get the time at which an open breaker closes.
+     */
+    std::chrono::system_clock::time_point getClosesAt() const { return _closes_at; }
+
+private:
+    void onCooldown();
+
+    using Clock = std::chrono::steady_clock;
+
+    JobConfig::Breaker            _config;
+    State                         _state;
+    std::deque<Clock::time_point> _restarts;
+
+    std::chrono::system_clock::time_point _closes_at;
+    Timer                                 _cooldown;
+    std::function<void()>                 _on_close;
+};
+} // namespace taskmasterd
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <string>
+#include <sys/stat.h>
+#include <unordered_map>
+#include <vector>
+
+#include <taskmasterd/include/jobs/JobConfig.hpp>
+#include <utils/include/utils.hpp>
+
+namespace taskmasterd
+{
+/**
+ * @brief Loads the job configurations of the main config file and the files it includes.
+ *
+ * The main file can list glob patterns under 'include', relative patterns are resolved from the
+ * directory of the main file. Every file is parsed on its own and cached by its inode, size and
+ * modification time, a load only parses the files that changed since the previous load.
+ *
+ * The cache can be kept in a binary snapshot on disk. A daemon that starts with an up to date
+ * snapshot only has to hash the files to verify it, instead of parsing them.
+ */
+class ConfigLoader
+{
+public:
+    using ConfigMap = std::unordered_map<std::string, JobConfig>;
+
+    /**
+     * @brief Construct a new ConfigLoader object.
+     *
+     * @param path The path of the main config file.
+     * @param snapshot_path The path of the snapshot that is read at construction and written after
+     * every load that changed the cache, an empty path disables the snapshot.
+     */
+    ConfigLoader(const std::string& path, const std::string& snapshot_path = "");
+
+    /**
+     * @brief Get the snapshot path set through the TASKMASTERD_SNAPSHOT environment variable.
+     *
+     * @return The path, or an empty string if the snapshot is disabled.
+     */
+    static std::string getSnapshotPath();
+
+    /**
+     * @brief Load the job configurations of all files.
+     *
+     * A job name that is defined in more than one file is reported and the first definition is
+     * used, the main file goes first and the included files follow in sorted order.
+     *
+     * @return The job configurations by name.
+     * @throw std::runtime_error if a file cannot be parsed or the dependencies of the jobs are
+     * invalid, the cache is left untouched.
+     */
+    ConfigMap load();
+
+    /**
+     * @brief Get the problems that were found during the last load.
+     */
+    const std::vector<std::string>& getWarnings() const { return _warnings; }
+
+    /**
+     * @brief Get the amount of files that were parsed during the last load.
+     */
+    usize getParsedFiles() const { return _parsed_files; }
+
+    /**
+     * @brief Get the amount of files that were part of the last load.
+     */
+    usize getTotalFiles() const { return _files.size(); }
+
+    const std::string& getPath() const { return _path; }
+
+    /**
+     * @brief Get the path of the main file and the include patterns of the last load, relative
+     * patterns are resolved from the directory of the main file.
+     */
+    std::vector<std::string> getPatterns() const;
+
+private:
+    // bump whenever JobConfig or the parsing of an option changes, older snapshots are ignored
+    static constexpr u32 SNAPSHOT_VERSION = 7;
+
+    struct File
+    {
+        ino_t           inode;
+        off_t           size;
+        struct timespec mtime;
+        u64             hash;     // of the content
+        bool            verified; // false for files from the snapshot until their hash was checked
+
+        ConfigMap                configs;
+        std::vector<std::string> includes; // only used by the main file
+        std::vector<std::string> warnings; // reported again on every load while the file is unchanged
+    };
+
+    /**
+     * @brief Get a file from the cache, or parse it again when it changed on disk.
+     *
+     * @param files The cache to fill.
+     * @param path The path of the file.
+     * @param main Whether this is the main config file.
+     */
+    const File& getFile(std::unordered_map<std::string, File>& files, const std::string& path, bool main);
+
+    /**
+     * @brief Check that every job only depends on jobs that exist and that the dependencies do not form a cycle.
+     *
+     * @throw std::runtime_error naming the unknown job or the jobs of the cycle.
+     */
+    static void checkDependencies(const ConfigMap& configs);
+
+    /**
+     * @brief Check if a cached file has the same inode, size and modification time as on disk.
+     */
+    static bool isSame(const File& file, const struct stat& info);
+
+    /**
+     * @brief Fill the cache from the snapshot, an invalid or outdated snapshot is ignored.
+     */
+    void readSnapshot();
+
+    /**
+     * @brief Write the cache to the snapshot, a failure is logged and otherwise ignored.
+     */
+    void writeSnapshot();
+
+    /**
+     * @brief Make a relative include pattern relative to the directory of the main file.
+     */
+    std::string resolvePattern(const std::string& pattern) const;
+
+    /**
+     * @brief Resolve the include patterns of the main file to a sorted list of paths.
+     */
+    std::vector<std::string> resolveIncludes(const std::vector<std::string>& patterns) const;
+
+    std::string                           _path;
+    std::string                           _snapshot_path;
+    std::unordered_map<std::string, File> _files;
+    std::vector<std::string>              _warnings;
+    usize                                 _parsed_files;
+    bool                                  _dirty; // the cache changed since the snapshot was written
+};
+} // namespace taskmasterd
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <ipc/include/FileDescriptor.hpp>
+#include <taskmasterd/include/core/Timer.hpp>
+#include <utils/include/utils.hpp>
+
+namespace taskmasterd
+{
+/**
+ * @brief Watches the config files with inotify and reports when they changed.
+ *
+ * The directories of the files are watched instead of the files themselves, so files that are
+ * replaced by a rename, as most editors and deployment tools do, stay watched. A burst of events
+ * is collapsed into a single call of on_change once no event arrived for the debounce interval.
+ */
+class ConfigWatcher : public ipc::FileDescriptor
+{
+public:
+    static constexpr TimerWheel::Duration DEFAULT_DEBOUNCE = std::chrono::milliseconds(100);
+
+    /**
+     * @brief Construct a new ConfigWatcher object.
+     *
+     * @param on_change Called once the watched files stopped changing for the debounce interval.
+     * @param debounce The time to wait after the last event.
+     * @throw std::runtime_error if the inotify instance could not be created.
+     */
+    ConfigWatcher(std::function<void()> on_change, TimerWheel::Duration debounce = DEFAULT_DEBOUNCE);
+    ~ConfigWatcher();
+
+    /**
+     * @brief Check if the watcher was requested through the TASKMASTERD_WATCH environment variable.
+     *
+     * @return true if TASKMASTERD_WATCH is set to 1.
+     */
+    static bool isEnabled();
+
+    /**
+     * @brief Watch the files that match the given paths or glob patterns, replacing the previous set.
+     *
+     * Only the file name may contain glob characters, a directory that cannot be watched is logged and skipped.
+     */
+    void watch(const std::vector<std::string>& patterns);
+
+private:
+    /**
+     * @brief Read the pending inotify events and restart the debounce timer when a watched file changed.
+     */
+    void onEvent();
+
+    /**
+     * @brief Check if a file name in a watched directory matches one of its patterns.
+     */
+    bool isWatched(i32 wd, const char* name) const;
+
+    std::function<void()> _on_change;
+    Timer                 _debounce;
+
+    // the file name patterns per watched directory, keyed by the inotify watch descriptor
+    std::unordered_map<i32, std::vector<std::string>> _watches;
+};
+} // namespace taskmasterd
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <sys/types.h>
+
+#include <ipc/include/FileDescriptor.hpp>
+#include <taskmasterd/include/jobs/JobConfig.hpp>
+#include <taskmasterd/include/jobs/Spawner.hpp>
+#include <utils/include/utils.hpp>
+
+namespace taskmasterd
+{
+/**
+ * @brief Everything needed to spawn the processes of a job, prepared once per spawn fingerprint.
+ *
+ * The binary is resolved against PATH and opened with O_PATH so it can be executed with
+ * execveat. The strings of argv, env and the paths are packed together with the argv and envp
+ * pointer arrays into a single arena. A plan is immutable: the processes of a job, and jobs that
+ * are recreated with the same spawn options, share it and spawning does not allocate.
+ */
+class ExecPlan
+{
+public:
+    ExecPlan(const ExecPlan&)            = delete;
+    ExecPlan& operator=(const ExecPlan&) = delete;
+
+    /**
+     * @brief Get the plan for the spawn options of a config, it is built on first use.
+     */
+    static std::shared_ptr<const ExecPlan> get(const JobConfig& config);
+
+    /**
+     * @brief Drop the cached plans that are not used by any job anymore.
+     */
+    static void prune();
+
+    /**
+     * @brief Build the spawn request of a process.
+     *
+     * The O_PATH fd is only used while the resolved path still refers to the same binary, a binary
+     * that was replaced on disk is executed by its path again.
+     *
+     * @param pgid The process group to join, 0 to start a new one.
+     */
+    SpawnRequest getRequest(pid_t pgid) const;
+
+    const char* getPath() const { return _request.path; }
+
+private:
+    explicit ExecPlan(const JobConfig& config);
+
+    /**
+     * @brief Find the binary of argv[0] in PATH, taken from the job env first and from the daemon otherwise.
+     *
+     * @return The path to execute, argv[0] itself when it contains a slash or cannot be found.
+     */
+    static std::string resolve(const JobConfig& config);
+
+    std::unique_ptr<char[]> _arena;
+    SpawnRequest            _request;
+
+    // the binary behind the O_PATH fd, to notice when it was replaced
+    ipc::FileDescriptor _binary;
+    dev_t               _device;
+    ino_t               _inode;
+};
+} // namespace taskmasterd
@@ -1,10 +1,14 @@
 #pragma once
 
+#include <array>
+#include <initializer_list>
 #include <iostream>
 #include <memory>
 #include <unistd.h>
 #include <vector>
 
+#include <taskmasterd/include/jobs/CircuitBreaker.hpp>
+#include <taskmasterd/include/jobs/ExecPlan.hpp>
 #include <taskmasterd/include/jobs/JobConfig.hpp>
 #include <taskmasterd/include/jobs/Process.hpp>
 
@@ -38,7 +42,8 @@ public:
     /**
      * @brief Start all processes defined in the job configuration.
      *
-     * This method forks and execs the specified command for 'numprocs' times
+     * This method queues 'numprocs' processes in the spawn queue, which forks and execs the
+     * specified command for each of them.
      */
     void start();
 
@@ -71,7 +76,46 @@ public:
      * This method is needed to update the job state to running when all processes surpasses the start time 
      * @param proc 
      */
-    void onProcessSurpassedStartTime();
+    void onProcessSurpassedStartTime(Process& proc);
+
+    /**
+     * @brief Replace the processes of the job in batches of 'rollingbatch' percent.
+     *
+     * Every process of a batch is stopped and started again, the next batch follows once all
+     * processes of the batch surpassed the start time. The rolling restart is aborted when a
+     * process of the batch will not be restarted anymore.
+     */
+    void rollingRestart();
+
+    /**
+     * @brief Apply a new configuration that does not require a restart of the processes.
+     *
+     * A changed numprocs is applied in place: the extra processes are started, or the surplus
+     * processes with the highest index are stopped and removed once they stopped.
+     *
+     * @param config The new configuration, must not require a restart of the job.
+     */
+    void applyConfig(const JobConfig& config);
+
+    /**
+     * @brief Remove the surplus processes of a smaller numprocs that stopped.
+     */
+    void trimProcesses();
+
+    /**
+     * @brief Check if the job still has surplus processes to remove.
+     */
+    bool hasSurplus() const { return _processes.size() > static_cast<u32>(_config.numprocs); }
+
+    /**
+     * @brief Check if a rolling restart is in progress.
+     */
+    bool isRolling() const { return !_rolling_batch.empty(); }
+
+    /**
+     * @brief Get the amount of processes a rolling restart already replaced.
+     */
+    u32 getRollingProgress() const { return _rolling_next - _rolling_batch.size(); }
 
     /**
      * @brief Get the job configuration.
@@ -123,6 +167,11 @@ public:
      */
     State getState() const { return _state; }
 
+    /**
+     * @brief Get the circuit breaker that guards the automatic restarts of this job.
+     */
+    const CircuitBreaker& getBreaker() const { return _breaker; }
+
 private:
     /**
      * @brief Helper method to create and start each process
@@ -139,33 +188,100 @@ private:
     /**
      * @brief Helper method to check if all processes are in certain states.
      *
-     * @param  Process::State vector state a process state
+     * Uses the per state counters, the cost does not depend on the amount of processes.
+     *
+     * @param  states the process states
      * @return boolean
      */
-    bool allProcessesInStates(std::vector<Process::State> state);
+    bool allProcessesInStates(std::initializer_list<Process::State> states) const;
 
     /**
-     * @brief Helper method to parse argument (argv, cmd)
-     *
+     * @brief Called by a process when it changes state to update the per state counters.
+     */
+    void onProcessStateChange(Process::State previous, Process::State current);
+
+    /**
+     * @brief Called by a process when it schedules or drops a delayed start.
+     */
+    void onScheduledStartChange(i32 delta) { _scheduled_starts += delta; }
+
+    /**
+     * @brief Check if no process of the job is running or about to be started again.
      */
-    void parseArguments(const JobConfig& config);
+    bool allProcessesIdle() const;
 
     /**
-     * @brief Helper method to parse Parse environment variables
+     * @brief Restart a process that exited after the backoff delay of its restart count.
      *
+     * @return false if the circuit breaker refused the restart, the process is FATAL then.
      */
-    void parseEnvironment(const JobConfig& config);
+    bool scheduleRestart(Process& proc);
 
-    JobConfig                _config;
-    JobManager&              _manager;
-    std::vector<std::string> _arg_store;
-    std::vector<const char*> _argv;
-    std::vector<const char*> _env;
-    std::vector<std::string> _env_store;
+    /**
+     * @brief Called when the circuit breaker closes, FATAL processes are started again.
+     */
+    void onBreakerClosed();
+
+    /**
+     * @brief Stop and start the next batch of a rolling restart.
+     */
+    void startRollingBatch();
+
+    /**
+     * @brief Helper method to create a new process at the end of the process list.
+     */
+    Process& addProcess();
+
+    /**
+     * @brief Check if a process is beyond numprocs and waits to be removed.
+     */
+    bool isSurplus(const Process& proc) const;
+
+    /**
+     * @brief Check if a process is part of the current batch of a rolling restart.
+     */
+    bool inRollingBatch(const Process& proc) const;
+
+    /**
+     * @brief Give up on the rolling restart.
+     */
+    void abortRollingRestart(const std::string& reason);
+
+    /**
+     * @brief Helper method to queue a process in the spawn queue with the priority of the job.
+     */
+    void startProcess(Process& proc);
+
+    /**
+     * @brief Called by a process when it leaves the spawn queue, starts it with the prepared arguments of the job.
+     */
+    void launchProcess(Process& proc);
+
+    /**
+     * @brief Called by a process that could not be spawned, it is FATAL like a process without retries left.
+     */
+    void onLaunchFailed(Process& proc);
+
+    JobConfig                       _config;
+    JobManager&                     _manager;
+    std::shared_ptr<const ExecPlan> _plan;
 
     State                                 _state;
     pid_t                                 _pgid;
     std::vector<std::unique_ptr<Process>> _processes;
+
+    // amount of processes in each Process::State
+    std::array<u32, Process::STATE_COUNT> _state_counts;
+
+    // amount of processes waiting in BACKOFF for a scheduled start
+    u32 _scheduled_starts;
+
+    CircuitBreaker _breaker;
+
+    // processes of the current rolling restart batch that did not surpass the start time yet
+    std::vector<Process*> _rolling_batch;
+    // index of the first process of the next rolling restart batch
+    u32 _rolling_next;
 };
 
 std::ostream& operator<<(std::ostream& os, const Job& job);
@@ -12,6 +12,11 @@
 #include <utils/include/utils.hpp>
 #include <yaml-cpp/yaml.h>
 
+namespace proto
+{
+class JobConfigSnapshot;
+}
+
 namespace taskmasterd
 {
 struct JobConfig
@@ -19,10 +24,34 @@ struct JobConfig
     static std::unordered_map<std::string, JobConfig> getJobConfigs(const std::string& filename);
 
     /**
-     * @brief A comparison operator overload to compare two configs. A default can be used since all members have the comparison operator
+     * @brief Parse the job configurations of a 'jobs' node, invalid jobs are skipped.
+     *
+     * @param jobs The 'jobs' node of a configuration file.
+     */
+    static std::unordered_map<std::string, JobConfig> getJobConfigs(const YAML::Node& jobs);
+
+    /**
+     * @brief Store the parsed options in a snapshot message.
+     */
+    void toSnapshot(proto::JobConfigSnapshot& message) const;
+
+    /**
+     * @brief Restore a config from a snapshot message, the options were validated when it was written.
+     */
+    static JobConfig fromSnapshot(const proto::JobConfigSnapshot& message);
+
+    /**
+     * @brief A comparison operator overload to compare two configs, only the fingerprints are compared.
      */
-    bool operator==(const JobConfig& obj) const = default;
-    bool operator!=(const JobConfig& obj) const = default;
+    bool operator==(const JobConfig& obj) const { return fingerprint == obj.fingerprint; }
+    bool operator!=(const JobConfig& obj) const { return fingerprint != obj.fingerprint; }
+
+    /**
+     * @brief Check if switching to another config requires the processes to be restarted.
+     *
+     * Only the options that change how a process is spawned do, the others are applied in place.
+     */
+    bool requiresRestart(const JobConfig& obj) const { return spawn_fingerprint != obj.spawn_fingerprint; }
 
     enum class RestartPolicy
     {
@@ -31,12 +60,54 @@ struct JobConfig
         ON_FAILURE
     };
 
+    /**
+     * @brief Delay before an automatic restart: base * factor ^ (restarts - 1), capped at max and
+     * spread randomly by +- jitter (a fraction of the delay).
+     */
+    struct Backoff
+    {
+        double base;   // seconds
+        double factor;
+        double max;    // seconds
+        double jitter; // 0 to 1
+
+        bool operator==(const Backoff& obj) const = default;
+    };
+
+    /**
+     * @brief More than 'threshold' automatic restarts within 'window' seconds park the processes
+     * of the job in FATAL for 'cooldown' seconds, a threshold of 0 disables the breaker.
+     */
+    struct Breaker
+    {
+        i32 threshold;
+        i32 window;   // seconds
+        i32 cooldown; // seconds
+
+        bool operator==(const Breaker& obj) const = default;
+    };
+
+    /**
+     * @brief Rotation of a log file: once it reaches 'max_bytes', or every 'interval' seconds, the file
+     * becomes backup 1 and the older backups move up, at most 'backups' are kept.
+     */
+    struct Rotation
+    {
+        u64  max_bytes; // 0 for no size limit
+        u32  backups;   // 0 truncates the file instead
+        i32  interval;  // seconds, 0 to only rotate by size
+        bool compress;  // the backups are compressed with gzip
+
+        bool operator==(const Rotation& obj) const = default;
+    };
+
     using EnvMap    = std::unordered_map<std::string, std::string>;
     using SignalMap = std::unordered_map<std::string, Signals>;
     using PolicyMap = std::unordered_map<std::string, RestartPolicy>;
 
-    std::string name;
-    std::string cmd;
+    std::string              name;
+    std::string              cmd;
+    std::vector<std::string> argv; // cmd split into arguments, with the variables expanded
     std::string working_dir;
     i32         numprocs;
     mode_t      umask;
@@ -45,17 +116,32 @@ struct JobConfig
     RestartPolicy    restart_policy;
     std::vector<i32> exit_codes;
 
-    i32 start_retries;
-    i32 start_time;
-    i32 stop_time;
+    i32  start_retries;
+    i32  start_time;
+    i32  stop_time;
+    bool notify; // the process reports READY=1 on NOTIFY_SOCKET, start_time is the timeout for it
+
+    Backoff backoff;
+    Breaker breaker;
+
+    i32 rolling_batch; // percentage of the processes replaced at a time by a rolling restart
+    i32 priority;      // processes of jobs with a lower priority leave the spawn queue first
+
+    std::vector<std::string> depends_on; // jobs that have to be RUNNING before this job starts
 
     Signals stop_signal;
 
     std::optional<std::string> out;
     std::optional<std::string> err;
+    Rotation                   out_rotation;
+    Rotation                   err_rotation;
 
     EnvMap env;
 
+    // hash of all options, and of the options that change how a process is spawned
+    u64 fingerprint;
+    u64 spawn_fingerprint;
+
     inline static const SignalMap signals = {
         {"HUP", Signals::HUP},
         {"INT", Signals::INT},
@@ -71,7 +157,20 @@ struct JobConfig
 private:
     // You are not supposed to create your own JobConfig objects, use the static method
     // getJobConfigs instead.
+    JobConfig() = default;
     JobConfig(const std::string& name, const YAML::Node& config);
+
+    /**
+     * @brief Split cmd into argv, variables are taken from env first and then from the daemon.
+     *
+     * @throw std::runtime_error if cmd is empty or cannot be split.
+     */
+    void splitCommand();
+
+    /**
+     * @brief Compute the fingerprints from the parsed options.
+     */
+    void computeFingerprints();
 };
 
 } // namespace taskmasterd
\ No newline at end of file
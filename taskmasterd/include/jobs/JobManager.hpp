@@ -1,9 +1,16 @@
 #pragma once
 
+#include <memory>
+#include <optional>
 #include <proto/taskmaster.pb.h>
 #include <string>
+#include <taskmasterd/include/jobs/ConfigLoader.hpp>
+#include <taskmasterd/include/jobs/ConfigWatcher.hpp>
 #include <taskmasterd/include/jobs/Job.hpp>
+#include <taskmasterd/include/jobs/OutputFollower.hpp>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace taskmasterd
 {
@@ -16,6 +23,18 @@ public:
     using ConfigMap = std::unordered_map<std::string, JobConfig>;
     using JobMap    = std::unordered_map<std::string, Job>;
 
+    /**
+     * @brief What a reload does with every job, built by comparing the config fingerprints.
+     */
+    struct ReloadPlan
+    {
+        std::vector<std::string> added;     // jobs that are new in the config
+        std::vector<std::string> removed;   // jobs that are not in the config anymore
+        std::vector<std::string> restarted; // jobs with changed options that require a restart
+        std::vector<std::string> updated;   // jobs with changed options that are applied in place
+        usize                    unchanged = 0;
+    };
+
     /**
      * @brief Construct a job manager that accepts the config file path
      * it will parse and construct the individual jobs
@@ -60,14 +79,16 @@ public:
      * if a program is not running this will start the program
      *
      * @param job_name
+     * @param rolling Replace the processes in batches instead of all at once.
      * @throw std::runtime_error if the job cannot be found.
      */
-    proto::CommandResponse restart(const std::string& job_name);
+    proto::CommandResponse restart(const std::string& job_name, bool rolling = false);
 
     /**
      * @brief Reload the default configuration file
      * this will stop all jobs and start all jobs with the autostart config
      *
+     * With TASKMASTERD_WATCH enabled this is also called once the config files stopped changing on disk.
      */
     proto::CommandResponse reload();
 
@@ -81,6 +102,36 @@ public:
      */
     proto::CommandResponse status(const std::string& job_name);
 
+    /**
+     * @brief Returns the last output of the processes of a job inside of a CommandResponse.
+     *
+     * The output of every process starts with a "==> name <==" header when the job has more than one.
+     *
+     * @param target The name of the job, or "name:index" for a single process.
+     * @param from_stderr Return the captured stderr instead of stdout.
+     * @param bytes The amount of output to return per process.
+     * @param follower Follows the output of the processes after the returned output, if given.
+     */
+    proto::CommandResponse tail(const std::string& target, bool from_stderr, usize bytes, OutputFollower* follower = nullptr);
+
+    /**
+     * @brief Returns the output of a job from the journal inside of a CommandResponse.
+     *
+     * The output of both streams of all processes is returned in the order it arrived, with a
+     * "==> name stream <==" header whenever it changes. At most about MAX_LOGS_BYTES of the newest
+     * output is returned. With 'since' the index seeks to the cutoff and the journal is read forward
+     * from there, without it the journal is read back from the newest output, at most MAX_LOGS_SCAN
+     * bytes of it.
+     *
+     * @param target The name of the job, or "name:index" for a single process.
+     * @param since Only return the output of the last 'since' seconds, the newest output in the journal without it.
+     */
+    proto::CommandResponse logs(const std::string& target, std::optional<u64> since);
+
+    static constexpr usize MAX_LOGS_BYTES  = 1024 * 1024;
+    static constexpr usize LOGS_CHUNK_SIZE = 64 * 1024;
+    static constexpr u64   MAX_LOGS_SCAN   = 64 * 1024 * 1024;
+
     /**
      * @brief Removes or replaces jobs marked as REMOVED or REPLACED
      */
@@ -89,10 +140,19 @@ public:
     /**
      * @brief This function is called by a job object once it's stopped. The manager can handle how it likes
      *
+     * Jobs that wait for their dependents to stop are stopped once the last one stopped.
+     *
      * @param job_name
      */
     void onStop(const std::string job_name);
 
+    /**
+     * @brief Called by a job once all its processes surpassed the start time.
+     *
+     * Jobs that wait for their dependencies are started once the last one is RUNNING.
+     */
+    void onRunning(const std::string& job_name);
+
 private:
     /**
      * @brief Helper function to find a specific job in the map
@@ -104,14 +164,57 @@ private:
     Job& findJob(const std::string& job_name);
 
     /**
-     * @brief Helper functon to create a new job
+     * @brief Compare the loaded config with the running jobs.
+     */
+    ReloadPlan planReload() const;
+
+    /**
+     * @brief Helper functon to create a new job, it is not started
      *
      */
     void createJob(const std::string& job_name);
 
-    JobMap      _jobs;
-    ConfigMap   _config;
-    std::string _config_path;
+    /**
+     * @brief Start jobs together with the dependencies that are not RUNNING yet.
+     *
+     * A job starts once all its dependencies are RUNNING, the jobs of a level of the dependency
+     * graph start together.
+     */
+    void startJobs(const std::vector<std::string>& names);
+
+    /**
+     * @brief Stop jobs together with the jobs that depend on them, in reverse dependency order.
+     *
+     * A job stops once all its dependents are stopped.
+     */
+    void stopJobs(const std::vector<std::string>& names);
+
+    /**
+     * @brief Check if all dependencies of a job are RUNNING.
+     */
+    bool dependenciesRunning(const std::string& job_name) const;
+
+    /**
+     * @brief Check if no dependent of a job has processes that are up.
+     */
+    bool dependentsStopped(const std::string& job_name) const;
+
+    /**
+     * @brief Build the reverse edges of the dependency graph from the loaded config.
+     */
+    void mapDependents();
+
+    JobMap                         _jobs;
+    ConfigMap                      _config;
+    ConfigLoader                   _loader;
+    std::unique_ptr<ConfigWatcher> _watcher; // only set when TASKMASTERD_WATCH is enabled
+
+    // the jobs that depend on a job, by the name of the job
+    std::unordered_map<std::string, std::vector<std::string>> _dependents;
+
+    // jobs that wait for their dependencies to run, and jobs that wait for their dependents to stop
+    std::unordered_set<std::string> _waiting_start;
+    std::unordered_set<std::string> _waiting_stop;
 };
 
 } // namespace taskmasterd
\ No newline at end of file
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <ipc/include/FileDescriptor.hpp>
+#include <utils/include/utils.hpp>
+
+namespace taskmasterd
+{
+/**
+ * @brief A single append-only journal with the output of all processes, enabled by setting
+ * TASKMASTERD_JOURNAL to a directory.
+ *
+ * The journal is a directory of numbered segments. A new segment starts when the daemon starts and
+ * when the current one reaches SEGMENT_SIZE, the oldest segments are removed beyond MAX_SEGMENTS.
+ * Every chunk of output is a record tagged with its job, process index, stream and the monotonic
+ * time it arrived. A segment starts with the wall clock and monotonic time of its creation, so the
+ * timestamps of its records can be compared with the wall clock after a reboot.
+ *
+ * Every segment has a sparse index with the timestamp and offset of a record every INDEX_INTERVAL
+ * bytes. A query for recent output goes straight to the segment and the record where it starts,
+ * instead of scanning the journal.
+ */
+class Journal
+{
+public:
+    static constexpr u64   SEGMENT_SIZE   = 64 * 1024 * 1024;
+    static constexpr usize MAX_SEGMENTS   = 16;
+    static constexpr u64   INDEX_INTERVAL = 64 * 1024;
+
+    enum class Stream : u8
+    {
+        STDOUT,
+        STDERR,
+    };
+
+    /**
+     * @brief The process stream that output comes from.
+     */
+    struct Source
+    {
+        std::string job;
+        u32         index;
+        Stream      stream;
+    };
+
+    /**
+     * @brief A record read back from the journal, the views are only valid during the visit.
+     */
+    struct Record
+    {
+        std::string_view job;
+        u32              index;
+        Stream           stream;
+        i64              time; // wall clock in nanoseconds since the epoch
+        std::string_view data;
+    };
+
+    using Visitor = std::function<void(const Record& record)>;
+
+    /**
+     * @brief Visits the records of a block oldest first, returns false to stop the walk.
+     */
+    using BlockVisitor = std::function<bool(const std::vector<Record>& records)>;
+
+    ~Journal() = default;
+
+    Journal(const Journal&)            = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    /**
+     * @brief Check if TASKMASTERD_JOURNAL is set.
+     */
+    static bool isEnabled();
+
+    /**
+     * @brief Append a record, a journal that cannot be written anymore is stopped.
+     */
+    void append(const Source& source, const char* data, usize size);
+
+    /**
+     * @brief Visit the records that arrived at or after a point in time, oldest first.
+     *
+     * @param since The wall clock in nanoseconds since the epoch.
+     */
+    void read(i64 since, const Visitor& visitor) const;
+
+    /**
+     * @brief Visit the records newest first.
+     *
+     * The segments are walked back in the blocks between their index entries, about INDEX_INTERVAL
+     * bytes each, the records within a block are visited oldest first. The walk stops when the
+     * visitor returns false or after scanning 'limit' bytes.
+     *
+     * @param limit The amount of the journal to scan at most.
+     * @return false if the walk stopped at the limit before the oldest record.
+     */
+    bool readNewest(u64 limit, const BlockVisitor& visitor) const;
+
+    const std::string& getDirectory() const { return _directory; }
+
+    /**
+     * @brief Get the singleton instance of Journal, the first segment is created on first use.
+     *
+     * @return The singleton instance.
+     * @throw std::runtime_error if the directory or the segment cannot be created.
+     */
+    static Journal& getInstance();
+
+private:
+    Journal();
+
+    /**
+     * @brief Start a new segment and remove the oldest ones beyond MAX_SEGMENTS.
+     *
+     * @throw std::runtime_error if the segment cannot be created.
+     */
+    void roll();
+
+    /**
+     * @brief Visit the records of a segment that arrived at or after a point in time.
+     */
+    void readSegment(u32 sequence, i64 since, const Visitor& visitor) const;
+
+    /**
+     * @brief Find the offset of the last indexed record of a segment that arrived before a timestamp.
+     *
+     * @param timestamp A timestamp on the monotonic clock of the segment.
+     */
+    u64 seek(u32 sequence, i64 timestamp) const;
+
+    std::string getPath(u32 sequence, const char* extension) const;
+
+    std::string      _directory;
+    std::vector<u32> _segments; // the sequence numbers of the segments, oldest first
+
+    // the segment that is appended to and its index
+    ipc::FileDescriptor _segment;
+    ipc::FileDescriptor _index;
+    u64                 _size;
+    u64                 _indexed; // the offset from which the next record is indexed
+};
+} // namespace taskmasterd
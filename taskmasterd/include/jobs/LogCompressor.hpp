@@ -0,0 +1,87 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <ipc/include/FileDescriptor.hpp>
+#include <utils/include/utils.hpp>
+
+namespace taskmasterd
+{
+/**
+ * @brief Compresses rotated log files on a worker thread, so a large file cannot stall the event loop.
+ *
+ * A file is compressed to 'path.gz' and removed once the compressed file is complete. The worker
+ * wakes the event loop through an eventfd when it finished a file, the results are logged from
+ * the event loop.
+ */
+class LogCompressor : public ipc::FileDescriptor
+{
+public:
+    ~LogCompressor();
+
+    LogCompressor(const LogCompressor&)            = delete;
+    LogCompressor& operator=(const LogCompressor&) = delete;
+
+    /**
+     * @brief Queue a file to be compressed.
+     */
+    void compress(const std::string& path);
+
+    /**
+     * @brief Check if a file is queued or being compressed, it must not be renamed until it is done.
+     */
+    bool isCompressing(const std::string& path) const { return _pending.find(path) != _pending.end(); }
+
+    /**
+     * @brief Get the singleton instance of LogCompressor, the worker thread is started on first use.
+     *
+     * @return The singleton instance.
+     * @throw std::runtime_error if the eventfd could not be created.
+     */
+    static LogCompressor& getInstance();
+
+private:
+    LogCompressor();
+
+    struct Result
+    {
+        std::string                path;
+        std::optional<std::string> error;
+    };
+
+    /**
+     * @brief Main loop of the worker thread, compresses the queued files until the daemon stops.
+     */
+    void run(std::stop_token token);
+
+    /**
+     * @brief Compress a single file on the worker thread.
+     *
+     * @return The error, if the file could not be compressed.
+     */
+    static std::optional<std::string> compressFile(const std::string& path);
+
+    /**
+     * @brief Called on the event loop when the worker finished files.
+     */
+    void onDone();
+
+    // files that were queued and are not done yet, only used on the event loop
+    std::unordered_set<std::string> _pending;
+
+    // shared with the worker
+    std::mutex                  _mutex;
+    std::condition_variable_any _wake;
+    std::deque<std::string>     _queue;
+    std::vector<Result>         _results;
+
+    std::jthread _thread;
+};
+} // namespace taskmasterd
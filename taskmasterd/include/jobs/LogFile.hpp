@@ -0,0 +1,90 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <ipc/include/FileDescriptor.hpp>
+#include <taskmasterd/include/core/Timer.hpp>
+#include <taskmasterd/include/jobs/JobConfig.hpp>
+#include <utils/include/utils.hpp>
+
+namespace taskmasterd
+{
+/**
+ * @brief A log file of the daemon, shared by all streams that write to the same path.
+ *
+ * The daemon is the only writer of the file, it keeps track of the size itself and writes at the
+ * end of the file without O_APPEND, which splice does not support. The file is rotated by the
+ * daemon while the processes keep running: it is renamed to 'path.1', the older backups move up
+ * and a new file is opened for all streams at once.
+ */
+class LogFile : public ipc::FileDescriptor
+{
+public:
+    ~LogFile();
+
+    LogFile(const LogFile&)            = delete;
+    LogFile& operator=(const LogFile&) = delete;
+
+    /**
+     * @brief Get the log file of a path, it is opened or created when no stream uses it yet.
+     *
+     * @param path The path of the file.
+     * @param rotation The rotation of the file, it replaces the rotation of the streams that use it already.
+     * @throw std::runtime_error if the file cannot be opened.
+     */
+    static std::shared_ptr<LogFile> get(const std::string& path, const JobConfig::Rotation& rotation);
+
+    /**
+     * @brief Change the rotation, an interval that changed starts over.
+     */
+    void setRotation(const JobConfig::Rotation& rotation);
+
+    /**
+     * @brief Append bytes to the file.
+     *
+     * @return false if the file cannot be written, errno is set.
+     */
+    bool write(const char* data, usize size);
+
+    /**
+     * @brief Append bytes from a pipe to the file without copying them.
+     *
+     * @return The amount of bytes that were moved, -1 with errno set like splice.
+     */
+    isize splice(i32 pipe, usize size);
+
+    /**
+     * @brief Rotate the file, unless it is empty.
+     *
+     * The rotation is postponed while the previous backup is still being compressed.
+     */
+    void rotate();
+
+    const std::string& getPath() const { return _path; }
+    u64                getSize() const { return _size; }
+
+private:
+    LogFile(const std::string& path, const JobConfig::Rotation& rotation);
+
+    /**
+     * @brief Account for bytes that were appended, the file is rotated once it reached its maximum size.
+     */
+    void onWritten(usize size);
+
+    /**
+     * @brief Get the path of a backup.
+     */
+    std::string getBackup(u32 index, bool compressed) const;
+
+    std::string            _path;
+    JobConfig::Rotation    _rotation;
+    u64                    _size;
+    bool                   _postponed; // a rotation waits for the compression of the previous backup
+    std::unique_ptr<Timer> _timer;
+
+    // the open log files by path, the streams own them
+    static std::unordered_map<std::string, std::weak_ptr<LogFile>> _files;
+};
+} // namespace taskmasterd
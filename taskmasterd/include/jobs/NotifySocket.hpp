@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <unordered_map>
+
+#include <ipc/include/FileDescriptor.hpp>
+#include <utils/include/utils.hpp>
+
+namespace taskmasterd
+{
+class Process;
+
+/**
+ * @brief Receives the readiness notifications of the processes, compatible with sd_notify.
+ *
+ * The processes of a job with 'notify' enabled get the address of the socket in NOTIFY_SOCKET
+ * and send datagrams of newline separated KEY=VALUE pairs to it. The kernel attaches the
+ * credentials of the sender, so a message is matched to its process by pid. READY=1 moves the
+ * process from STARTING to RUNNING.
+ */
+class NotifySocket : public ipc::FileDescriptor
+{
+public:
+    ~NotifySocket();
+
+    NotifySocket(const NotifySocket&)            = delete;
+    NotifySocket& operator=(const NotifySocket&) = delete;
+
+    /**
+     * @brief Get the value for NOTIFY_SOCKET, an abstract socket address starting with '@'.
+     */
+    const std::string& getAddress() const { return _address; }
+
+    /**
+     * @brief Deliver the notifications of a pid to a process until it unsubscribes.
+     */
+    void subscribe(pid_t pid, Process& proc);
+
+    /**
+     * @brief Stop delivering the notifications of a pid, only if they are delivered to the given process.
+     */
+    void unsubscribe(pid_t pid, const Process& proc);
+
+    /**
+     * @brief Get the singleton instance of NotifySocket, the socket is bound on first use.
+     *
+     * @return The singleton instance.
+     * @throw std::runtime_error if the socket could not be created.
+     */
+    static NotifySocket& getInstance();
+
+private:
+    NotifySocket();
+
+    /**
+     * @brief Read the pending datagrams and hand them to the processes that sent them.
+     */
+    void onMessage();
+
+    /**
+     * @brief Handle the KEY=VALUE pairs of a single datagram.
+     */
+    void handle(Process& proc, std::string_view message);
+
+    std::string                         _address;
+    std::unordered_map<pid_t, Process*> _processes;
+};
+} // namespace taskmasterd
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <taskmasterd/include/jobs/OutputStream.hpp>
+#include <utils/include/utils.hpp>
+
+namespace taskmasterd
+{
+/**
+ * @brief Follows the output of processes for a client, like tail -f.
+ *
+ * Only the offset up to which a stream was collected is kept, the output itself stays in the ring
+ * buffer of the stream. A client that collects slower than the processes write loses the oldest
+ * output instead of growing the memory of the daemon, the collected output says how many bytes
+ * were dropped.
+ */
+class OutputFollower : public OutputStream::Listener
+{
+public:
+    using Callback = std::function<void()>;
+
+    /**
+     * @brief Construct a new OutputFollower object.
+     *
+     * @param on_change Called when new output can be collected or a followed stream is gone.
+     */
+    explicit OutputFollower(Callback on_change);
+    ~OutputFollower();
+
+    OutputFollower(const OutputFollower&)            = delete;
+    OutputFollower& operator=(const OutputFollower&) = delete;
+
+    /**
+     * @brief Follow a stream from the output that arrives next.
+     *
+     * @param name The name of the process, shown above its output when several are followed.
+     */
+    void follow(const std::string& name, OutputStream& stream);
+
+    /**
+     * @brief Stop following all streams.
+     */
+    void clear();
+
+    bool isFollowing() const { return !_streams.empty(); }
+
+    /**
+     * @brief Get the output of all streams since the last call.
+     */
+    std::string collect();
+
+    void onOutput(OutputStream& stream) override;
+    void onClosed(OutputStream& stream) override;
+
+private:
+    struct Followed
+    {
+        std::string   name;
+        OutputStream* stream;
+        u64           offset; // the offset in the ring buffer up to which the output was collected
+    };
+
+    std::vector<Followed> _streams;
+    const OutputStream*   _last; // the stream of the last collected output, a header is added when it changes
+    Callback              _on_change;
+};
+} // namespace taskmasterd
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <ipc/include/FileDescriptor.hpp>
+#include <taskmasterd/include/core/RingBuffer.hpp>
+#include <taskmasterd/include/jobs/JobConfig.hpp>
+#include <taskmasterd/include/jobs/Journal.hpp>
+#include <taskmasterd/include/jobs/LogFile.hpp>
+#include <utils/include/utils.hpp>
+
+namespace taskmasterd
+{
+/**
+ * @brief Captures the stdout or stderr of a process through a pipe owned by the daemon.
+ *
+ * The read end of the pipe is registered with the EventManager. Everything the process writes is
+ * kept in a ring buffer, so the last output can be fetched without touching the disk, and appended
+ * to the configured file. The buffer outlives the runs of the process, every start gets a new pipe.
+ *
+ * The output does not pass through the memory of the daemon: it is spliced from the pipe to the
+ * file, and tee'd into a second pipe, the tap, that holds the newest bytes for the ring buffer.
+ * Bytes that are pushed out of the tap are dropped in the kernel, the ring buffer only reads the
+ * tap when its contents are requested. Without a file the output is spliced into the tap. Where
+ * splice is not supported the output is read and written instead.
+ *
+ * Listeners are told when new output arrived, they fetch it from the ring buffer by offset.
+ *
+ * With the journal enabled the output is also appended to it, the output is then read and written
+ * since the journal needs it in memory anyway.
+ */
+class OutputStream : public ipc::FileDescriptor
+{
+public:
+    static constexpr usize DEFAULT_CAPACITY = 64 * 1024;
+
+    /**
+     * @brief Is told about new output of a stream, like a client that follows it.
+     */
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+
+        /**
+         * @brief Called after new output arrived, it may still be in the tap until getBuffer is called.
+         */
+        virtual void onOutput(OutputStream& stream) = 0;
+
+        /**
+         * @brief Called when the stream is destroyed, the listener is removed already.
+         */
+        virtual void onClosed(OutputStream& stream) = 0;
+    };
+
+    /**
+     * @brief Construct a new OutputStream object.
+     *
+     * @param name The name of the stream used in the logs, like "web_0 stdout".
+     * @param capacity The amount of output that is kept in memory.
+     */
+    OutputStream(const std::string& name, usize capacity = DEFAULT_CAPACITY);
+    ~OutputStream();
+
+    OutputStream(const OutputStream&)            = delete;
+    OutputStream& operator=(const OutputStream&) = delete;
+
+    /**
+     * @brief Check if splice was not disabled by setting the TASKMASTERD_SPLICE environment variable to 0.
+     */
+    static bool isSpliceEnabled();
+
+    /**
+     * @brief Create the pipe for a new run of the process.
+     *
+     * The pipe of a previous run that is still held open, by a process it left behind, is read
+     * one last time and closed.
+     *
+     * @param sink The file the output is appended to, none to only keep it in memory.
+     * @param rotation The rotation of the file.
+     * @return The write end of the pipe for the child, to be closed once the process is spawned.
+     * @throw std::runtime_error if the pipe or the file cannot be opened.
+     */
+    ipc::FileDescriptor open(const std::optional<std::string>& sink, const JobConfig::Rotation& rotation);
+
+    /**
+     * @brief Change the rotation of the file the output is appended to, if there is one.
+     */
+    void setRotation(const JobConfig::Rotation& rotation);
+
+    /**
+     * @brief Append the output to the journal as well, must be called before the first run.
+     */
+    void setJournal(const Journal::Source& source);
+
+    /**
+     * @brief Get the ring buffer with all output up to now, the bytes waiting in the tap are moved into it first.
+     */
+    const RingBuffer& getBuffer();
+
+    /**
+     * @brief Tell a listener about the new output until it is removed.
+     */
+    void addListener(Listener& listener);
+    void removeListener(Listener& listener);
+
+    const std::string& getName() const { return _name; }
+
+private:
+    /**
+     * @brief Handle the output that is available in the pipe, the pipe is closed once the process closed its end.
+     */
+    void onReadable();
+
+    /**
+     * @brief Move the available output to the file and the tap without copying it.
+     *
+     * @return false if splice is not supported, the output has to be copied instead.
+     */
+    bool transfer();
+
+    /**
+     * @brief Read what is available in the pipe into the ring buffer and the file.
+     */
+    void copy();
+
+    /**
+     * @brief Splice bytes that were tee'd into the tap from the pipe to the file.
+     *
+     * @return false if the file does not support splice, the bytes are written instead.
+     */
+    bool spliceSink(usize size);
+
+    /**
+     * @brief Append output to the file, a file that cannot be written anymore is closed.
+     */
+    void writeSink(const char* data, usize size);
+
+    /**
+     * @brief Drop the oldest bytes of the tap, the ring buffer skips them.
+     */
+    void evict(usize size);
+
+    /**
+     * @brief Read the tap into the ring buffer.
+     */
+    void flush();
+
+    /**
+     * @brief Unregister and close the pipe and the file.
+     */
+    void detach();
+
+    std::string                    _name;
+    RingBuffer                     _buffer;
+    std::shared_ptr<LogFile>       _sink;
+    std::optional<Journal::Source> _journal;
+    bool                           _splice;
+
+    // the pipe with the newest output that is not in the ring buffer yet
+    ipc::FileDescriptor _tap_read;
+    ipc::FileDescriptor _tap_write;
+    usize               _tapped;
+
+    std::vector<Listener*> _listeners;
+};
+} // namespace taskmasterd
@@ -1,17 +1,21 @@
 #pragma once
 
 #include "taskmasterd/include/jobs/Signal.hpp"
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <unistd.h>
 
 #include <ipc/include/FileDescriptor.hpp>
 #include <taskmasterd/include/core/Timer.hpp>
 #include <taskmasterd/include/jobs/JobConfig.hpp>
+#include <taskmasterd/include/jobs/OutputStream.hpp>
 
 namespace taskmasterd
 {
-
+class ExecPlan;
 class Job;
 class Process : public ipc::FileDescriptor
 {
@@ -19,6 +23,7 @@ public:
     enum class State
     {
         STOPPED,  // The process has been stopped due to a stop request or has never been started.
+        QUEUED,   // The process waits in the spawn queue to be started.
         STARTING, // The process is starting due to a start request.
         RUNNING,  // The process is running.
         BACKOFF,  // The process entered the STARTING state but subsequently exited too quickly
@@ -29,27 +34,58 @@ public:
         UNKNOWN   // The process state is unknown. (programming error)
     };
 
+    static constexpr usize STATE_COUNT = static_cast<usize>(State::UNKNOWN) + 1;
+
     /**
      * @brief Construct a new Process object.
      *
      * @param name The name of the process.
-     * @param pgid The process group ID. If 0, the child's PID will be used as PGID.
+     * @param index The index of the process in its job.
      */
-    Process(const std::string& name, pid_t pgid, Job& job);
-    virtual ~Process() = default;
+    Process(const std::string& name, u32 index, Job& job);
+    virtual ~Process();
 
     /**
-     * @brief Start the process by forking and executing the specified command.
+     * @brief Queue the process in the spawn queue, it is started once it leaves the queue.
+     *
+     * A pending start is cancelled, a process that is queued already keeps its place.
      *
-     * @param path The path to the executable.
-     * @param argv The argument list for the executable.
-     * @param env The environment variables for the executable.
+     * @param priority The priority of the job, lower priorities are started first.
      */
-    void start(const std::string& path, char* const* argv, char* const* env, const JobConfig& config);
+    void enqueue(i32 priority);
+
+    /**
+     * @brief Called by the spawn queue when the process leaves it, the job starts the process.
+     *
+     * A process that cannot be spawned is FATAL and its job is told like for a failed start.
+     *
+     * @return false if the process could not be spawned.
+     */
+    bool launch();
+
+    /**
+     * @brief Start the process by spawning and executing the specified command.
+     *
+     * The stdout and stderr of the process are pipes to the daemon, the output is kept in memory
+     * and appended to the files of the config.
+     *
+     * @param plan The prepared binary, arguments and environment of the job.
+     * @param config The config of the job.
+     * @param pgid The process group ID. If 0, the child's PID will be used as PGID.
+     * @throw std::runtime_error if the output files cannot be opened or the process cannot be spawned.
+     */
+    void start(const ExecPlan& plan, const JobConfig& config, pid_t pgid);
+
+    /**
+     * @brief Apply the rotation of the log files of a reloaded config, the process keeps running.
+     */
+    void setLogRotation(const JobConfig& config);
 
     /**
      * @brief Gracefully stop the process using SIGTERM.
      *
+     * A STOPPED process is left alone and a STOPPING one keeps waiting for its pending kill timer.
+     *
      * @param timeout The time in seconds to wait for the process to terminate gracefully
      *                before forcefully killing it. Default is 5 seconds.
      * @param stop_signal The signal to send to the program to call a stop
@@ -63,6 +99,34 @@ public:
      */
     void kill();
 
+    /**
+     * @brief Start the process again after a delay.
+     *
+     * The process waits in the BACKOFF state on a timer of the event loop, stopping the process
+     * cancels the pending start.
+     *
+     * @param delay The time to wait before the start.
+     * @param start Called once the delay passed to start the process.
+     */
+    void scheduleStart(TimerWheel::Duration delay, std::function<void()> start);
+
+    /**
+     * @brief Give up on a process that exited, it stays FATAL until it is started again.
+     *
+     * A pending start is cancelled.
+     */
+    void fail();
+
+    /**
+     * @brief Give up on a process because the circuit breaker of its job opened, it is started again once the breaker closes.
+     */
+    void park();
+
+    /**
+     * @brief Called by the notify socket when the process sent READY=1, a STARTING process is RUNNING right away.
+     */
+    void onReady();
+
     /**
      * @brief Callack for state changes.
      *
@@ -76,8 +140,21 @@ public:
 
     i32 getRestarts() const { return _restarts; }
 
+    /**
+     * @brief Check if the process is FATAL because the circuit breaker parked it.
+     */
+    bool isParked() const { return _parked; }
+
+    /**
+     * @brief Get the time of the next scheduled start, if the process waits for one.
+     */
+    const std::optional<std::chrono::system_clock::time_point>& getNextAttempt() const { return _next_attempt; }
+
     const std::string& getName() const { return _name; }
 
+    OutputStream& getStdout() { return _stdout; }
+    OutputStream& getStderr() { return _stderr; }
+
     void addRestart() { _restarts++; }
     void resetRestarts() { _restarts = 0; }
 
@@ -104,19 +181,35 @@ private:
     void onStartTime();
 
     /**
-     * @brief Helper method to dup a path instead of a fd
+     * @brief Method is called once the start time passed for a process that did not report ready
      *
-     * the reason is to safe line spaces
+     * the process is killed and its exit is handled as a failed start
+     */
+    void onStartTimeout();
+
+    /**
+     * @brief Change the state of the process and keep the state counters of the job up to date.
+     */
+    void setState(State state);
+
+    /**
+     * @brief Forget the scheduled start, the caller is responsible for its timer.
      */
-    void dupPath(i32 std_input, const std::string& path);
+    void clearNextAttempt();
 
     std::string _name;
     pid_t       _pid;
-    pid_t       _pgid;
     State       _state;
     i32         _restarts;
     Job&        _job;
+    bool        _notify; // the process reports its readiness on the notify socket
+    bool        _parked; // FATAL by the circuit breaker instead of failed starts
 
     std::unique_ptr<Timer> _timer;
+
+    OutputStream _stdout;
+    OutputStream _stderr;
+
+    std::optional<std::chrono::system_clock::time_point> _next_attempt;
 };
 } // namespace taskmasterd
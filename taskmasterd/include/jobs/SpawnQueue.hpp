@@ -0,0 +1,106 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+#include <taskmasterd/include/core/Timer.hpp>
+#include <utils/include/utils.hpp>
+
+namespace taskmasterd
+{
+class Process;
+
+/**
+ * @brief Orders and throttles the starts of all processes of the daemon.
+ *
+ * A start request only queues the process, the queue is drained from a timer of the event loop:
+ * processes leave it by job priority and then in the order they were queued, as long as fewer than
+ * 'max starting' processes are in the STARTING state and the spawn rate allows it. Every drain
+ * spawns at most DRAIN_BATCH processes, the event loop serves the ctl clients in between.
+ */
+class SpawnQueue
+{
+public:
+    struct Limits
+    {
+        u32    max_starting; // processes in the STARTING state at the same time, 0 for no limit
+        double rate;         // spawns per second, 0 for no limit
+    };
+
+    SpawnQueue(const SpawnQueue&)            = delete;
+    SpawnQueue& operator=(const SpawnQueue&) = delete;
+
+    /**
+     * @brief Read the limits from the TASKMASTERD_MAX_STARTING and TASKMASTERD_SPAWN_RATE environment variables.
+     *
+     * @throw std::runtime_error if a variable is not a number.
+     */
+    static Limits getLimits();
+
+    /**
+     * @brief Queue a process to be started, Process::launch is called once it leaves the queue.
+     *
+     * @param proc The process, must not be queued already.
+     * @param priority The priority of its job, lower priorities leave the queue first.
+     */
+    void push(Process& proc, i32 priority);
+
+    /**
+     * @brief Remove a queued process without starting it.
+     */
+    void remove(Process& proc);
+
+    /**
+     * @brief Called by a process when it enters or leaves the STARTING state.
+     */
+    void onStartingChange(i32 delta);
+
+    usize getQueued() const { return _queue.size(); }
+    u32   getStarting() const { return _starting; }
+
+    /**
+     * @brief Get the singleton instance of SpawnQueue.
+     *
+     * @return The singleton instance.
+     */
+    static SpawnQueue& getInstance();
+
+    static constexpr u32 DEFAULT_MAX_STARTING = 64;
+    static constexpr u32 DRAIN_BATCH          = 32;
+
+private:
+    SpawnQueue();
+
+    /**
+     * @brief Start the processes at the front of the queue that the limits allow.
+     */
+    void drain();
+
+    /**
+     * @brief Arm the drain timer when processes are waiting, it fires on the next tick of the event loop.
+     */
+    void schedule();
+
+    /**
+     * @brief Add the spawns that the rate allows since the last refill, at most a tenth of a second worth.
+     */
+    void refill();
+
+    using Key   = std::pair<i32, u64>; // priority, sequence number
+    using Clock = std::chrono::steady_clock;
+
+    Limits _limits;
+
+    std::map<Key, Process*>           _queue;
+    std::unordered_map<Process*, Key> _keys;
+    u64                               _sequence;
+    u32                               _starting;
+
+    double            _tokens;
+    Clock::time_point _refilled;
+
+    Timer _timer;
+};
+} // namespace taskmasterd
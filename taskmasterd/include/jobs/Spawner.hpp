@@ -0,0 +1,90 @@
+#pragma once
+
+#include <fcntl.h>
+#include <string>
+#include <sys/types.h>
+
+#include <utils/include/utils.hpp>
+
+namespace taskmasterd
+{
+/**
+ * @brief Everything the child needs between clone and execve.
+ *
+ * All strings are prepared by the parent, the child shares the memory of the daemon until it
+ * calls execve and must not allocate.
+ */
+struct SpawnRequest
+{
+    const char*  path;
+    char* const* argv;
+    char* const* env;
+    const char*  working_dir;
+    pid_t        pgid; // If 0, pid of the child process is used as pgid
+    mode_t       umask;
+    i32          exec_fd   = -1; // O_PATH fd of the binary to execute with execveat, -1 to execute path
+    i32          stdout_fd = -1; // write end of the output pipe, -1 to inherit the stdout of the daemon
+    i32          stderr_fd = -1; // write end of the output pipe, -1 to inherit the stderr of the daemon
+};
+
+struct SpawnResult
+{
+    pid_t       pid;
+    i32         pidfd;
+    i32         error;       // errno of the step that failed in the child, 0 if it reached execve
+    const char* failed_step; // description of the step that failed in the child
+};
+
+/**
+ * @brief Starts processes without copying the address space of the daemon.
+ *
+ * The child is created with clone(CLONE_VM | CLONE_VFORK | CLONE_PIDFD): it runs on a separate
+ * stack inside the memory of the daemon until it calls execve, which makes the cost of a spawn
+ * independent of the size of the daemon. The pidfd is returned by the same system call that
+ * creates the child.
+ */
+class Spawner
+{
+public:
+    Spawner();
+    ~Spawner();
+
+    Spawner(const Spawner&)            = delete;
+    Spawner& operator=(const Spawner&) = delete;
+
+    /**
+     * @brief Spawn a new process.
+     *
+     * Returns once the child called execve or exited, when the child failed before execve the
+     * error and failed step are set in the result and the child exits with a non zero status.
+     *
+     * @param request The prepared arguments of the new process.
+     * @param flags Additional clone flags, the zygote passes CLONE_PARENT so the daemon stays the parent.
+     * @return The pid and pidfd of the new process.
+     * @throw std::runtime_error if the process could not be created.
+     */
+    SpawnResult spawn(const SpawnRequest& request, i32 flags = 0);
+
+    /**
+     * @brief Map the description of a failed step, like one received from the zygote, to the static one for a SpawnResult.
+     */
+    static const char* findStep(const std::string& step);
+
+    /**
+     * @brief Get the singleton instance of Spawner.
+     *
+     * @return The singleton instance.
+     */
+    static Spawner& getInstance();
+
+private:
+    /**
+     * @brief Entry point of the child, runs on the spawn stack until execve.
+     */
+    static i32 childMain(void* arg);
+
+    static constexpr usize STACK_SIZE = 256 * 1024;
+
+    void* _stack;
+};
+} // namespace taskmasterd
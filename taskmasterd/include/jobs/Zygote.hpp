@@ -0,0 +1,97 @@
+#pragma once
+
+#include <sys/types.h>
+#include <vector>
+
+#include <ipc/include/FileDescriptor.hpp>
+#include <taskmasterd/include/jobs/Spawner.hpp>
+#include <utils/include/utils.hpp>
+
+namespace proto
+{
+class SpawnRequest;
+}
+
+namespace taskmasterd
+{
+/**
+ * @brief Small helper process that spawns the processes of the daemon.
+ *
+ * The zygote is forked at boot, before any job is loaded, and only keeps the standard streams and
+ * its end of a socketpair open. Spawn requests are sent to it as SpawnRequest messages, with the
+ * output pipes of the process, and it answers with a SpawnResponse, the pidfd of the new process
+ * is passed along with SCM_RIGHTS.
+ *
+ * The zygote spawns with CLONE_PARENT, the daemon stays the parent of every process so their
+ * pidfds and waitpid work exactly as for processes spawned by the daemon itself.
+ */
+class Zygote
+{
+public:
+    ~Zygote();
+
+    Zygote(const Zygote&)            = delete;
+    Zygote& operator=(const Zygote&) = delete;
+
+    /**
+     * @brief Check if the zygote was requested through the TASKMASTERD_ZYGOTE environment variable.
+     *
+     * @return true if TASKMASTERD_ZYGOTE is set to 1.
+     */
+    static bool isEnabled();
+
+    /**
+     * @brief Fork the zygote process, should be called before the daemon allocates its jobs.
+     *
+     * @throw std::runtime_error if the zygote could not be started.
+     */
+    void start();
+
+    /**
+     * @brief Check if the zygote is available to spawn processes.
+     */
+    bool isRunning() const { return _socket.getFd() != -1; }
+
+    /**
+     * @brief Spawn a new process through the zygote.
+     *
+     * When the zygote is gone it is shut down and the process is spawned by the daemon instead.
+     *
+     * @param request The prepared arguments of the new process.
+     * @return The pid and pidfd of the new process.
+     * @throw std::runtime_error if the process could not be created.
+     */
+    SpawnResult spawn(const SpawnRequest& request);
+
+    /**
+     * @brief Get the singleton instance of Zygote.
+     *
+     * @return The singleton instance.
+     */
+    static Zygote& getInstance();
+
+private:
+    Zygote();
+
+    /**
+     * @brief Main loop of the zygote process, serves spawn requests until the daemon closes the socket.
+     */
+    [[noreturn]] void run();
+
+    /**
+     * @brief Serve a single spawn request inside the zygote process.
+     *
+     * @param message The request.
+     * @param fds The pipes of the process that were passed along with the request.
+     */
+    void serve(const proto::SpawnRequest& message, const std::vector<i32>& fds);
+
+    /**
+     * @brief Close the socket and reap the zygote process.
+     */
+    void shutdown();
+
+    ipc::FileDescriptor _socket;
+    pid_t               _pid;
+};
+} // namespace taskmasterd
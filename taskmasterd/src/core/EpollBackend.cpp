@@ -0,0 +1,78 @@
+#include <taskmasterd/include/core/EpollBackend.hpp>
+
+#include <stdexcept>
+#include <string.h>
+#include <string>
+#include <sys/epoll.h>
+
+namespace taskmasterd
+{
+EpollBackend::EpollBackend()
+    : EventBackend(epoll_create1(EPOLL_CLOEXEC))
+{
+    if (_fd == -1) {
+        throw std::runtime_error("Failed to create epoll file descriptor");
+    }
+}
+
+void EpollBackend::add(i32 fd, u32 events, u64 data)
+{
+    control(fd, EPOLL_CTL_ADD, events, data);
+}
+
+void EpollBackend::modify(i32 fd, u32 events, u64 data)
+{
+    control(fd, EPOLL_CTL_MOD, events, data);
+}
+
+void EpollBackend::control(i32 fd, i32 operation, u32 events, u64 data)
+{
+    // make sure the events are 0 initialized
+    struct epoll_event event{};
+    if (events & READ)
+        event.events |= EPOLLIN;
+    if (events & WRITE)
+        event.events |= EPOLLOUT;
+    event.data.u64 = data;
+
+    if (epoll_ctl(_fd, operation, fd, &event) == -1) {
+        throw std::runtime_error("Failed to update file descriptor in epoll: " + std::string(strerror(errno)));
+    }
+}
+
+void EpollBackend::remove(i32 fd)
+{
+    if (epoll_ctl(_fd, EPOLL_CTL_DEL, fd, nullptr) == -1) {
+        throw std::runtime_error("Failed to remove file descriptor from epoll: " + std::string(strerror(errno)));
+    }
+}
+
+i32 EpollBackend::wait(Event* events, i32 max_events)
+{
+    if (_events.size() < static_cast<usize>(max_events))
+        _events.resize(max_events);
+
+    struct epoll_event* epoll_events = _events.data();
+
+    i32 num_events = epoll_wait(_fd, epoll_events, max_events, -1);
+    if (num_events == -1) {
+        if (errno == EINTR)
+            // Interrupted by signal, just return
+            return 0;
+
+        throw std::runtime_error("epoll_wait failed: " + std::string(strerror(errno)));
+    }
+
+    for (i32 i = 0; i < num_events; i++) {
+        events[i].data   = epoll_events[i].data.u64;
+        events[i].events = 0;
+        // hangups and errors are reported to both handlers, they will see them on their next read or write
+        if (epoll_events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+            events[i].events |= READ;
+        if (epoll_events[i].events & (EPOLLOUT | EPOLLHUP | EPOLLERR))
+            events[i].events |= WRITE;
+    }
+
+    return num_events;
+}
+} // namespace taskmasterd
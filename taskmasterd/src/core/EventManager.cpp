@@ -1,84 +1,111 @@
-#include <iostream>
-#include <ostream>
 #include <taskmasterd/include/core/EventManager.hpp>
 
+#include <cstdlib>
 #include <stdexcept>
 #include <string.h>
-#include <sys/epoll.h>
 #include <unistd.h>
 
 #include <logger/include/Logger.hpp>
+#include <taskmasterd/include/core/EpollBackend.hpp>
+#ifdef TASKMASTER_IO_URING
+#include <taskmasterd/include/core/UringBackend.hpp>
+#endif
 
 namespace taskmasterd
 {
-EventManager::EventManager()
-    : FileDescriptor(epoll_create1(0))
+EventManager::EventManager(Backend backend)
 {
-    if (_fd == -1) {
-        throw std::runtime_error("Failed to create epoll file descriptor");
+    if (backend == Backend::IO_URING) {
+#ifdef TASKMASTER_IO_URING
+        try {
+            _backend = std::make_unique<UringBackend>();
+        } catch (const std::exception& e) {
+            LOG_WARNING(std::string(e.what()) + ", falling back to epoll");
+        }
+#else
+        LOG_WARNING("io_uring support is not built in, falling back to epoll");
+#endif
     }
+
+    if (!_backend)
+        _backend = std::make_unique<EpollBackend>();
+
+    LOG_INFO("Using the " + std::string(_backend->name()) + " event backend");
 }
 
-void EventManager::registerEvent(const FileDescriptor& handler, EventCallback read_callback, EventCallback write_callback)
+void EventManager::registerEvent(const ipc::FileDescriptor& handler, EventCallback read_callback, EventCallback write_callback)
 {
-    this->updateEventInternal(handler, EPOLL_CTL_ADD, read_callback, write_callback);
+    this->updateEventInternal(handler, true, read_callback, write_callback);
 }
 
-void EventManager::updateEvent(const FileDescriptor& handler, EventCallback read_callback, EventCallback write_callback)
+void EventManager::updateEvent(const ipc::FileDescriptor& handler, EventCallback read_callback, EventCallback write_callback)
 {
-    this->updateEventInternal(handler, EPOLL_CTL_MOD, read_callback, write_callback);
+    this->updateEventInternal(handler, false, read_callback, write_callback);
 }
 
-void EventManager::updateEventInternal(const FileDescriptor& handler, i32 operation, EventCallback read_callback, EventCallback write_callback)
+void EventManager::updateEventInternal(const ipc::FileDescriptor& handler, bool add, EventCallback read_callback, EventCallback write_callback)
 {
-    // make sure the events are 0 initialized 
-    struct epoll_event event{};
+    Handler& slot       = getHandler(handler.getFd());
+    u32      generation = slot.generation + 1;
+    u32      events     = 0;
+
     // Set the events based on the provided callbacks
     if (read_callback)
-        event.events |= EPOLLIN;
+        events |= EventBackend::READ;
     if (write_callback)
-        event.events |= EPOLLOUT;
-    event.data.fd = handler.getFd();
+        events |= EventBackend::WRITE;
+    // pack the generation together with the fd so stale events can be detected on dispatch
+    u64 data = (static_cast<u64>(generation) << 32) | static_cast<u32>(handler.getFd());
+
+    if (add)
+        _backend->add(handler.getFd(), events, data);
+    else
+        _backend->modify(handler.getFd(), events, data);
+
+    slot.generation     = generation;
+    slot.read_callback  = std::move(read_callback);
+    slot.write_callback = std::move(write_callback);
+}
 
-    if (epoll_ctl(_fd, operation, handler.getFd(), &event) == -1) {
-        throw std::runtime_error("Failed to update file descriptor in epoll: " + std::string(strerror(errno)));
-    }
+void EventManager::unregisterEvent(const ipc::FileDescriptor& handler)
+{
+    _backend->remove(handler.getFd());
 
-    _read_callbacks[handler.getFd()]  = read_callback;
-    _write_callbacks[handler.getFd()] = write_callback;
+    Handler& slot = getHandler(handler.getFd());
+
+    // invalidate any event of this fd that is still pending in the current batch
+    slot.generation++;
+    slot.read_callback  = nullptr;
+    slot.write_callback = nullptr;
 }
 
-void EventManager::unregisterEvent(const FileDescriptor& handler)
+EventManager::Handler& EventManager::getHandler(i32 fd)
 {
-    if (epoll_ctl(_fd, EPOLL_CTL_DEL, handler.getFd(), nullptr) == -1) {
-        throw std::runtime_error("Failed to remove file descriptor from epoll: " + std::string(strerror(errno)));
-    }
+    if (fd < 0)
+        throw std::runtime_error("Invalid file descriptor: " + std::to_string(fd));
 
-    _read_callbacks.erase(handler.getFd());
-    _write_callbacks.erase(handler.getFd());
+    if (static_cast<usize>(fd) >= _handlers.size())
+        _handlers.resize(fd + 1);
+
+    return _handlers[fd];
 }
 
 void EventManager::handleEvents()
 {
-    struct epoll_event events[MAX_EVENTS];
-
-    i32 num_events = epoll_wait(_fd, events, MAX_EVENTS, -1);
-    if (num_events == -1) {
-        if (errno == EINTR)
-            // Interrupted by signal, just return
-            return;
+    EventBackend::Event events[MAX_EVENTS];
 
-        throw std::runtime_error("epoll_wait failed: " + std::string(strerror(errno)));
-    }
+    i32 num_events = _backend->wait(events, MAX_EVENTS);
 
     for (i32 i = 0; i < num_events; i++) {
-        i32 fd = events[i].data.fd;
+        i32 fd         = static_cast<i32>(events[i].data & 0xffffffff);
+        u32 generation = static_cast<u32>(events[i].data >> 32);
         try {
-            if (events[i].events & EPOLLIN) {
-                _read_callbacks.at(fd)();
+            // a callback may unregister (or replace) any handler, so the generation is checked before every call
+            if (events[i].events & EventBackend::READ && isCurrent(fd, generation) && _handlers[fd].read_callback) {
+                _handlers[fd].read_callback();
             }
-            if (events[i].events & EPOLLOUT) {
-                _write_callbacks.at(fd)();
+            if (events[i].events & EventBackend::WRITE && isCurrent(fd, generation) && _handlers[fd].write_callback) {
+                _handlers[fd].write_callback();
             }
         } catch (const std::exception& e) {
             LOG_ERROR("Error handling event for fd " + std::to_string(fd) + ": " + e.what());
@@ -92,4 +119,20 @@ EventManager& EventManager::getInstance()
 
     return instance;
 }
+
+EventManager::Backend EventManager::getDefaultBackend()
+{
+    const char* backend = std::getenv("TASKMASTERD_EVENT_BACKEND");
+
+    if (backend != nullptr && std::string(backend) == "epoll")
+        return Backend::EPOLL;
+    if (backend != nullptr && std::string(backend) == "io_uring")
+        return Backend::IO_URING;
+
+#ifdef TASKMASTER_IO_URING
+    return Backend::IO_URING;
+#else
+    return Backend::EPOLL;
+#endif
+}
 } // namespace taskmasterd
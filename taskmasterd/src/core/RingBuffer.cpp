@@ -0,0 +1,99 @@
+#include <taskmasterd/include/core/RingBuffer.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <string.h>
+
+namespace taskmasterd
+{
+namespace
+{
+// the first allocation, smaller writes are rounded up to it
+constexpr usize MIN_ALLOCATION = 1024;
+} // namespace
+
+RingBuffer::RingBuffer(usize capacity)
+    : _allocated(0)
+    , _capacity(std::bit_ceil(std::max<usize>(capacity, 1)))
+    , _written(0)
+    , _start(0)
+{
+}
+
+void RingBuffer::write(const char* data, usize size)
+{
+    // only the last capacity bytes of a large write are kept, it replaces everything that was kept before
+    if (size >= _capacity) {
+        if (_allocated != _capacity) {
+            _data.reset(new char[_capacity]);
+            _allocated = _capacity;
+        }
+        _written += size - _capacity;
+        data += size - _capacity;
+        size = _capacity;
+    } else {
+        grow(size);
+    }
+
+    store(_written, data, size);
+    _written += size;
+}
+
+void RingBuffer::skip(u64 size)
+{
+    _written += size;
+    _start = _written;
+}
+
+void RingBuffer::grow(usize size)
+{
+    usize kept = getSize();
+
+    if (_allocated == _capacity || kept + size <= _allocated)
+        return;
+
+    // the kept bytes move to the places of their offsets in the larger memory
+    std::string             bytes     = readFrom(_written - kept);
+    usize                   allocated = std::min(_capacity, std::bit_ceil(std::max<usize>(kept + size, MIN_ALLOCATION)));
+    std::unique_ptr<char[]> data(new char[allocated]);
+
+    _data      = std::move(data);
+    _allocated = allocated;
+    store(_written - kept, bytes.data(), bytes.size());
+}
+
+void RingBuffer::store(u64 offset, const char* data, usize size)
+{
+    // the byte at an offset is stored at the offset modulo the allocated size
+    usize mask  = _allocated - 1;
+    usize start = offset & mask;
+    usize first = std::min(size, _allocated - start);
+
+    memcpy(_data.get() + start, data, first);
+    memcpy(_data.get(), data + first, size - first);
+}
+
+std::string RingBuffer::tail(usize size) const
+{
+    return readFrom(_written - std::min<u64>(size, getSize()));
+}
+
+std::string RingBuffer::readFrom(u64 offset) const
+{
+    u64 oldest = _written - getSize();
+
+    offset = std::clamp(offset, oldest, _written);
+
+    std::string result(_written - offset, '\0');
+    if (result.empty())
+        return result;
+
+    usize mask  = _allocated - 1;
+    usize start = offset & mask;
+    usize first = std::min<usize>(result.size(), _allocated - start);
+
+    memcpy(result.data(), _data.get() + start, first);
+    memcpy(result.data() + first, _data.get(), result.size() - first);
+    return result;
+}
+} // namespace taskmasterd
@@ -1,61 +1,49 @@
-#include <string>
 #include <taskmasterd/include/core/Timer.hpp>
 
-#include <stdexcept>
-#include <sys/timerfd.h>
-#include <unistd.h>
-
-#include <logger/include/Logger.hpp>
-#include <taskmasterd/include/core/EventManager.hpp>
-
 namespace taskmasterd
 {
 Timer::Timer(i32 interval, std::function<void()> callback)
+    : Timer(std::chrono::seconds(interval), callback)
+{
+}
+
+Timer::Timer(TimerWheel::Duration interval, std::function<void()> callback)
     : _interval(interval)
     , _state(State::STOPPED)
+    , _expiry(0)
     , _callback(callback)
 {
-    _fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
-    if (_fd == -1) {
-        throw std::runtime_error("Failed to create timerfd");
-    }
 }
 
 Timer::~Timer()
 {
-    if (_state == State::RUNNING) {
-        EventManager::getInstance().unregisterEvent(*this);
-    }
+    stop();
 }
 
 void Timer::start()
 {
-    struct itimerspec new_value;
-    new_value.it_value.tv_sec     = _interval;
-    new_value.it_value.tv_nsec    = 0;
-    new_value.it_interval.tv_sec  = _interval;
-    new_value.it_interval.tv_nsec = 0;
-
-    if (timerfd_settime(_fd, 0, &new_value, NULL) == -1) {
-        throw std::runtime_error("Failed to set timerfd time");
-    }
+    stop();
 
-    EventManager::getInstance().registerEvent(*this, std::bind(&Timer::onExpire, this), nullptr);
+    TimerWheel::getInstance().schedule(*this, _interval);
 
     _state = State::RUNNING;
 }
 
-void Timer::onExpire()
+void Timer::stop()
 {
+    if (_state == State::RUNNING) {
+        TimerWheel::getInstance().cancel(*this);
+    }
+
     _state = State::STOPPED;
+}
 
-    u64     expirations;
-    ssize_t s = read(_fd, &expirations, sizeof(expirations));
-    if (s != sizeof(expirations)) {
-        throw std::runtime_error("Failed to read timerfd");
-    }
+void Timer::onExpire()
+{
+    _state = State::STOPPED;
 
-    EventManager::getInstance().unregisterEvent(*this);
-    _callback();
+    // the callback is allowed to destroy this timer, so call a copy of it
+    std::function<void()> callback = _callback;
+    callback();
 }
 } // namespace taskmasterd
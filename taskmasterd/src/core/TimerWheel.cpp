@@ -0,0 +1,231 @@
+#include <taskmasterd/include/core/TimerWheel.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <logger/include/Logger.hpp>
+#include <taskmasterd/include/core/EventManager.hpp>
+#include <taskmasterd/include/core/Timer.hpp>
+
+namespace taskmasterd
+{
+void TimerWheel::Link::unlink()
+{
+    prev->next = next;
+    next->prev = prev;
+    prev       = this;
+    next       = this;
+}
+
+void TimerWheel::Link::pushBack(Link& node)
+{
+    node.prev  = prev;
+    node.next  = this;
+    prev->next = &node;
+    prev       = &node;
+}
+
+TimerWheel::TimerWheel()
+    : FileDescriptor(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC))
+    , _origin(std::chrono::steady_clock::now())
+    , _current(0)
+    , _pending(0)
+    , _armed(0)
+{
+    if (_fd == -1) {
+        throw std::runtime_error("Failed to create timerfd: " + std::string(strerror(errno)));
+    }
+
+    EventManager::getInstance().registerEvent(*this, std::bind(&TimerWheel::onTick, this), nullptr);
+}
+
+TimerWheel::~TimerWheel()
+{
+    EventManager::getInstance().unregisterEvent(*this);
+}
+
+void TimerWheel::schedule(Timer& timer, Duration delay)
+{
+    auto deadline = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _origin + delay);
+
+    // an idle wheel is not advanced, it can jump to now without passing any timer
+    if (_pending == 0)
+        _current = std::max(_current, getTick());
+
+    // the first tick that starts at or after the deadline, a timer never expires in the tick that is being handled
+    u64 expiry = (deadline.count() + TICK_NS - 1) / TICK_NS;
+
+    timer._expiry = std::max(expiry, _current + 1);
+    insert(timer);
+    _pending++;
+
+    if (_armed == 0 || timer._expiry < _armed)
+        arm(timer._expiry);
+}
+
+void TimerWheel::cancel(Timer& timer)
+{
+    if (!timer.linked())
+        return;
+
+    timer.unlink();
+    _pending--;
+}
+
+void TimerWheel::insert(Timer& timer)
+{
+    u64 delta = timer._expiry > _current ? timer._expiry - _current : 0;
+
+    // The highest level covers 2^32 ticks (~497 days), anything further is clamped to its edge
+    if (delta >= (u64(1) << (LEVELS * SLOT_BITS))) {
+        delta         = (u64(1) << (LEVELS * SLOT_BITS)) - 1;
+        timer._expiry = _current + delta;
+    }
+
+    // a timer lives on the lowest level whose span still reaches its expiry
+    u32 level = 0;
+    while (delta >= (u64(1) << ((level + 1) * SLOT_BITS)))
+        level++;
+
+    u32 slot = (timer._expiry >> (level * SLOT_BITS)) & SLOT_MASK;
+    _slots[level][slot].pushBack(timer);
+}
+
+void TimerWheel::cascade(u32 level)
+{
+    Link& slot = _slots[level][(_current >> (level * SLOT_BITS)) & SLOT_MASK];
+
+    while (slot.linked()) {
+        Timer& timer = static_cast<Timer&>(*slot.next);
+
+        timer.unlink();
+        insert(timer);
+    }
+}
+
+void TimerWheel::advance()
+{
+    _current++;
+
+    // whenever a lower level wraps around, the next slot of the level above is due to be redistributed
+    for (u32 level = 1; level < LEVELS; level++) {
+        if ((_current & ((u64(1) << (level * SLOT_BITS)) - 1)) != 0)
+            break;
+        cascade(level);
+    }
+
+    // Move the due timers to a local list, so callbacks can freely cancel or schedule timers
+    Link  expired;
+    Link& slot = _slots[0][_current & SLOT_MASK];
+    while (slot.linked()) {
+        Link& node = *slot.next;
+        node.unlink();
+        expired.pushBack(node);
+    }
+
+    while (expired.linked()) {
+        Timer& timer = static_cast<Timer&>(*expired.next);
+
+        timer.unlink();
+        _pending--;
+        try {
+            timer.onExpire();
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error handling timer expiration: " + std::string(e.what()));
+        }
+    }
+}
+
+void TimerWheel::advanceTo(u64 tick)
+{
+    while (_current < tick) {
+        u64 next = nextEvent();
+
+        // nothing happens in the ticks before the next event, they are skipped
+        if (next > tick) {
+            _current = tick;
+            return;
+        }
+        _current = next - 1;
+        advance();
+    }
+}
+
+u64 TimerWheel::nextEvent() const
+{
+    u64 next = UINT64_MAX;
+
+    if (_pending == 0)
+        return next;
+
+    // the first non-empty slot of every level, a higher level slot is due when the levels below wrap around to it
+    for (u32 level = 0; level < LEVELS; level++) {
+        u32 shift = level * SLOT_BITS;
+
+        for (u64 i = 1; i <= SLOTS; i++) {
+            u64 tick = ((_current >> shift) + i) << shift;
+
+            if (tick >= next)
+                break;
+            if (_slots[level][(tick >> shift) & SLOT_MASK].linked()) {
+                next = tick;
+                break;
+            }
+        }
+    }
+    return next;
+}
+
+u64 TimerWheel::getTick() const
+{
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _origin);
+
+    return elapsed.count() / TICK_NS;
+}
+
+void TimerWheel::onTick()
+{
+    u64     expirations;
+    ssize_t s = read(_fd, &expirations, sizeof(expirations));
+    if (s != sizeof(expirations)) {
+        if (s == -1 && errno == EAGAIN)
+            return;
+        throw std::runtime_error("Failed to read timerfd");
+    }
+
+    // catch up on the ticks that elapsed while the daemon slept, then sleep until the next one with work
+    _armed = 0;
+    advanceTo(getTick());
+    arm(_pending > 0 ? nextEvent() : 0);
+}
+
+void TimerWheel::arm(u64 tick)
+{
+    struct itimerspec new_value{};
+
+    // an absolute deadline on the clock of the wheel, a deadline in the past fires right away
+    if (tick != 0) {
+        auto deadline = std::chrono::duration_cast<std::chrono::nanoseconds>(_origin.time_since_epoch()) + std::chrono::nanoseconds(tick * TICK_NS);
+
+        new_value.it_value.tv_sec  = deadline.count() / 1000000000;
+        new_value.it_value.tv_nsec = deadline.count() % 1000000000;
+    }
+
+    if (timerfd_settime(_fd, TFD_TIMER_ABSTIME, &new_value, NULL) == -1) {
+        throw std::runtime_error("Failed to set timerfd time");
+    }
+
+    _armed = tick;
+}
+
+TimerWheel& TimerWheel::getInstance()
+{
+    static TimerWheel instance;
+
+    return instance;
+}
+} // namespace taskmasterd
@@ -0,0 +1,281 @@
+#ifdef TASKMASTER_IO_URING
+#include <taskmasterd/include/core/UringBackend.hpp>
+
+#include <algorithm>
+#include <poll.h>
+#include <stdexcept>
+#include <string.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <logger/include/Logger.hpp>
+
+namespace taskmasterd
+{
+static i32 io_uring_setup(u32 entries, struct io_uring_params* params)
+{
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+static i32 io_uring_enter(i32 fd, u32 to_submit, u32 min_complete, u32 flags)
+{
+    return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0);
+}
+
+static void* mapRing(i32 fd, usize size, off_t offset)
+{
+    void* ring = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+    if (ring == MAP_FAILED)
+        throw std::runtime_error("Failed to map io_uring ring: " + std::string(strerror(errno)));
+    return ring;
+}
+
+static u32* ringField(void* ring, u32 offset)
+{
+    return reinterpret_cast<u32*>(static_cast<char*>(ring) + offset);
+}
+
+UringBackend::UringBackend()
+    : EventBackend(-1)
+    , _ring(MAP_FAILED)
+    , _ring_size(0)
+    , _sqes(static_cast<struct io_uring_sqe*>(MAP_FAILED))
+    , _sqes_size(0)
+{
+    struct io_uring_params params{};
+    params.flags      = IORING_SETUP_CQSIZE;
+    params.cq_entries = CQ_ENTRIES;
+
+    _fd = io_uring_setup(SQ_ENTRIES, &params);
+    if (_fd == -1) {
+        throw std::runtime_error("Failed to set up io_uring: " + std::string(strerror(errno)));
+    }
+
+    // Without NODROP completions could get lost when the completion queue overflows
+    if (!(params.features & IORING_FEAT_NODROP) || !(params.features & IORING_FEAT_SINGLE_MMAP)) {
+        throw std::runtime_error("Failed to set up io_uring: kernel is too old");
+    }
+
+    // With SINGLE_MMAP the submission and completion rings share one mapping
+    usize sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+    usize cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+    _ring_size = std::max(sq_ring_size, cq_ring_size);
+    _ring      = mapRing(_fd, _ring_size, IORING_OFF_SQ_RING);
+
+    _sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    _sqes      = static_cast<struct io_uring_sqe*>(mapRing(_fd, _sqes_size, IORING_OFF_SQES));
+
+    _sq_head    = ringField(_ring, params.sq_off.head);
+    _sq_tail    = ringField(_ring, params.sq_off.tail);
+    _sq_array   = ringField(_ring, params.sq_off.array);
+    _sq_mask    = *ringField(_ring, params.sq_off.ring_mask);
+    _sq_entries = *ringField(_ring, params.sq_off.ring_entries);
+
+    _cq_head = ringField(_ring, params.cq_off.head);
+    _cq_tail = ringField(_ring, params.cq_off.tail);
+    _cq_mask = *ringField(_ring, params.cq_off.ring_mask);
+    _cqes    = reinterpret_cast<struct io_uring_cqe*>(static_cast<char*>(_ring) + params.cq_off.cqes);
+}
+
+UringBackend::~UringBackend()
+{
+    if (_sqes != MAP_FAILED)
+        munmap(_sqes, _sqes_size);
+    if (_ring != MAP_FAILED)
+        munmap(_ring, _ring_size);
+}
+
+UringBackend::Registration& UringBackend::getRegistration(i32 fd)
+{
+    if (fd < 0)
+        throw std::runtime_error("Invalid file descriptor: " + std::to_string(fd));
+
+    if (static_cast<usize>(fd) >= _registrations.size())
+        _registrations.resize(fd + 1);
+
+    return _registrations[fd];
+}
+
+void UringBackend::add(i32 fd, u32 events, u64 data)
+{
+    Registration& registration = getRegistration(fd);
+
+    if (registration.registered)
+        throw std::runtime_error("Failed to update file descriptor in io_uring: " + std::string(strerror(EEXIST)));
+
+    registration.registered = true;
+    registration.events     = events;
+    registration.data       = data;
+    queuePollAdd(fd, registration);
+}
+
+void UringBackend::modify(i32 fd, u32 events, u64 data)
+{
+    Registration& registration = getRegistration(fd);
+
+    if (!registration.registered)
+        throw std::runtime_error("Failed to update file descriptor in io_uring: " + std::string(strerror(ENOENT)));
+
+    if (registration.armed)
+        queuePollRemove(registration);
+
+    registration.events = events;
+    registration.data   = data;
+    queuePollAdd(fd, registration);
+}
+
+void UringBackend::remove(i32 fd)
+{
+    Registration& registration = getRegistration(fd);
+
+    if (!registration.registered)
+        throw std::runtime_error("Failed to remove file descriptor from io_uring: " + std::string(strerror(ENOENT)));
+
+    if (registration.armed)
+        queuePollRemove(registration);
+
+    registration = Registration();
+}
+
+struct io_uring_sqe* UringBackend::getSqe()
+{
+    u32 tail = *_sq_tail;
+
+    // the queue is full, hand it over to the kernel without waiting for completions
+    if (tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE) == _sq_entries) {
+        enter(0);
+        if (tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE) == _sq_entries)
+            throw std::runtime_error("io_uring submission queue is full");
+    }
+
+    u32                  index = tail & _sq_mask;
+    struct io_uring_sqe* sqe   = &_sqes[index];
+
+    memset(sqe, 0, sizeof(*sqe));
+    _sq_array[index] = index;
+    __atomic_store_n(_sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    return sqe;
+}
+
+void UringBackend::queuePollAdd(i32 fd, Registration& registration)
+{
+    struct io_uring_sqe* sqe = getSqe();
+
+    sqe->opcode    = IORING_OP_POLL_ADD;
+    sqe->fd        = fd;
+    sqe->user_data = registration.data;
+    if (registration.events & READ)
+        sqe->poll32_events |= POLLIN;
+    if (registration.events & WRITE)
+        sqe->poll32_events |= POLLOUT;
+
+    registration.armed = true;
+}
+
+void UringBackend::queuePollRemove(Registration& registration)
+{
+    struct io_uring_sqe* sqe = getSqe();
+
+    // poll requests are identified by the user data they were submitted with
+    sqe->opcode    = IORING_OP_POLL_REMOVE;
+    sqe->fd        = -1;
+    sqe->addr      = registration.data;
+    sqe->user_data = IGNORED;
+
+    registration.armed = false;
+}
+
+bool UringBackend::enter(u32 min_complete)
+{
+    u32 flags     = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+    u32 to_submit = *_sq_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+
+    if (io_uring_enter(_fd, to_submit, min_complete, flags) != -1)
+        return true;
+
+    // Interrupted by signal, entries that were not consumed stay queued
+    if (errno == EINTR)
+        return false;
+
+    // the completion queue overflowed or the kernel is out of memory, the caller has to reap completions first
+    if (errno == EBUSY || errno == EAGAIN)
+        return true;
+
+    throw std::runtime_error("io_uring_enter failed: " + std::string(strerror(errno)));
+}
+
+u32 UringBackend::toEvents(u32 poll_mask, u32 interest) const
+{
+    u32 events = 0;
+
+    // hangups and errors are reported to both handlers, they will see them on their next read or write
+    if (poll_mask & (POLLIN | POLLHUP | POLLERR))
+        events |= READ;
+    if (poll_mask & (POLLOUT | POLLHUP | POLLERR))
+        events |= WRITE;
+
+    return events & interest;
+}
+
+i32 UringBackend::wait(Event* events, i32 max_events)
+{
+    // re-arm the polls whose handlers ran since the previous wait
+    for (i32 fd : _rearm) {
+        Registration& registration = _registrations[fd];
+        if (registration.registered && !registration.armed)
+            queuePollAdd(fd, registration);
+    }
+    _rearm.clear();
+
+    // submit everything that was queued during the previous dispatch and wait in one system call
+    if (!enter(1))
+        return 0;
+
+    i32 num_events = 0;
+    u32 head       = *_cq_head;
+    u32 tail       = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail && num_events < max_events; head++) {
+        const struct io_uring_cqe& cqe = _cqes[head & _cq_mask];
+
+        if (cqe.user_data == IGNORED)
+            continue;
+
+        i32 fd = static_cast<i32>(cqe.user_data & 0xffffffff);
+        if (static_cast<usize>(fd) >= _registrations.size())
+            continue;
+
+        // completions of a previous registration of this fd, or of a removed poll, are stale
+        Registration& registration = _registrations[fd];
+        if (!registration.registered || !registration.armed || registration.data != cqe.user_data)
+            continue;
+
+        registration.armed = false;
+
+        // a failed poll is not re-armed, it would fail again on every iteration
+        if (cqe.res < 0) {
+            LOG_ERROR("io_uring poll failed for fd " + std::to_string(fd) + ": " + strerror(-cqe.res));
+            continue;
+        }
+
+        _rearm.push_back(fd);
+
+        u32 ready = toEvents(cqe.res, registration.events);
+        if (ready == 0)
+            continue;
+
+        events[num_events].data   = cqe.user_data;
+        events[num_events].events = ready;
+        num_events++;
+    }
+
+    __atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+
+    return num_events;
+}
+} // namespace taskmasterd
+#endif
@@ -13,6 +13,9 @@ namespace taskmasterd
 Client::Client(Socket&& socket, Server& server)
     // : ProtoReader<proto::Command>(std::move(socket))
     : Socket(std::move(socket))
+    , _writing(false)
+    , _streaming(false)
+    , _follower(std::bind(&Client::onFollowed, this))
     , _server(server)
 {
     EventManager::getInstance().registerEvent(*this, std::bind(&Client::handleRead, this), nullptr);
@@ -34,8 +37,7 @@ void Client::handleRead()
         // If bytes_read is 0, the client has disconnected
         if (bytes_read == 0) {
             LOG_INFO("Client disconnected with fd: " + std::to_string(_fd));
-            EventManager::getInstance().unregisterEvent(*this);
-            this->close();
+            this->disconnect();
             return;
         }
 
@@ -44,8 +46,7 @@ void Client::handleRead()
         }
     } catch (const std::exception& e) {
         LOG_ERROR("Error reading from client fd " + std::to_string(_fd) + ": " + e.what());
-        EventManager::getInstance().unregisterEvent(*this);
-        this->close();
+        this->disconnect();
     }
 }
 
@@ -54,18 +55,20 @@ void Client::handleWrite(proto::Command command)
     try {
         bool doneWriting = _proto_writer.write(*this);
         if (doneWriting) {
-            // Stop polling for writes and start polling for reads again
-            EventManager::getInstance().unregisterEvent(*this);
-            EventManager::getInstance().registerEvent(*this, std::bind(&Client::handleRead, this), nullptr);
             _proto_writer.clear();
+            _writing = false;
 
             if (command.type() == proto::CommandType::TERMINATE)
                 g_state = State::TERMINATED;
+
+            // Stop polling for writes and start polling for reads again, unless the stream has more to send
+            this->sendNext();
+            if (!_writing)
+                EventManager::getInstance().updateEvent(*this, std::bind(&Client::handleRead, this), nullptr);
         }
     } catch (const std::exception& e) {
         LOG_ERROR("Error writing to client fd: " + std::to_string(_fd) + ": " + e.what())
-        EventManager::getInstance().unregisterEvent(*this);
-        this->close();
+        this->disconnect();
     }
 }
 
@@ -74,25 +77,103 @@ void Client::handleMessage(proto::Command command)
     // Handle the received command
     LOG_INFO("Received command from client fd " + std::to_string(_fd) + ": " + command.DebugString());
 
-    // Stop reading new commands, we need to process the current command and write the response out first
-    EventManager::getInstance().unregisterEvent(*this);
+    // any command ends a stream, the client only sends one to stop it
+    if (_streaming) {
+        proto::CommandResponse response;
+
+        _streaming = false;
+        _follower.clear();
+        response.set_status(proto::CommandStatus::OK);
 
+        // the last message of the stream is sent after the one that is being written
+        _queued = response;
+        if (!_writing)
+            this->sendNext();
+        return;
+    }
+
+    proto::CommandResponse response;
     try {
         // call the server callback
-        proto::CommandResponse response = _server.onCommand(command);
-
-        // Get ready to send the command response
-        _proto_writer.init(response);
+        response = _server.onCommand(command, _follower);
     } catch (const std::exception& e) {
-        _proto_writer.clear();
+        _follower.clear();
 
-        proto::CommandResponse err_response;
+        response.set_status(proto::CommandStatus::ERROR);
+        response.set_message(std::string("Internal daemon error: ") + e.what());
+    }
 
-        err_response.set_status(proto::CommandStatus::ERROR);
-        err_response.set_message(std::string("Internal daemon error: ") + e.what());
-        _proto_writer.init(err_response);
+    // the response of 'tail --follow' is the start of a stream
+    if (_follower.isFollowing()) {
+        _streaming = true;
+        _followed  = command;
+        response.set_streaming(true);
     }
 
-    EventManager::getInstance().registerEvent(*this, nullptr, std::bind(&Client::handleWrite, this, command));
+    this->send(response, command);
+}
+
+void Client::send(proto::CommandResponse& response, const proto::Command& command)
+{
+    _proto_writer.init(response);
+    _writing = true;
+
+    // Stop reading new commands while the response is written out, only the end of a stream is read in the meantime
+    EventManager::getInstance().updateEvent(*this, _streaming ? std::bind(&Client::handleRead, this) : EventManager::EventCallback(nullptr),
+                                            std::bind(&Client::handleWrite, this, command));
+}
+
+void Client::sendNext()
+{
+    if (_queued.has_value()) {
+        proto::CommandResponse response = std::move(_queued.value());
+
+        _queued.reset();
+        this->send(response, _followed);
+        return;
+    }
+    if (!_streaming)
+        return;
+
+    // everything that arrived while the previous message was written is sent at once
+    std::string output = _follower.collect();
+    if (output.empty())
+        return;
+
+    proto::CommandResponse response;
+
+    response.set_status(proto::CommandStatus::OK);
+    response.set_output(output);
+    response.set_streaming(true);
+    this->send(response, _followed);
+}
+
+void Client::onFollowed()
+{
+    if (!_streaming || !this->isConnected())
+        return;
+
+    // the stream stays open until the client ends it, so it never answers a command that is not the end of the stream
+    if (!_follower.isFollowing()) {
+        proto::CommandResponse response;
+
+        response.set_status(proto::CommandStatus::OK);
+        response.set_message("The followed processes are gone, nothing more will be sent");
+        response.set_streaming(true);
+        _queued = response;
+    }
+
+    if (!_writing)
+        this->sendNext();
+}
+
+void Client::disconnect()
+{
+    EventManager::getInstance().unregisterEvent(*this);
+    this->close();
+
+    _streaming = false;
+    _follower.clear();
+    _queued.reset();
 }
 } // namespace taskmasterd
@@ -45,6 +45,59 @@ void Server::onAccept()
     _clients.erase(std::remove_if(_clients.begin(), _clients.end(), [](const std::unique_ptr<Client>& client) { return client->isConnected() == false; }), _clients.end());
 }
 
+#define ROLLING_OPTION "--rolling"
+#define STDERR_OPTION  "--stderr"
+#define BYTES_OPTION   "--bytes="
+#define FOLLOW_OPTION  "--follow"
+#define FOLLOW_SHORT   "-f"
+#define SINCE_OPTION   "--since="
+
+// the amount of output tail returns per process without --bytes
+#define DEFAULT_TAIL_BYTES 1600
+
+static bool isOption(const std::string& arg)
+{
+    return arg.rfind("--", 0) == 0 || arg == FOLLOW_SHORT;
+}
+
+/**
+ * @brief Parse a duration like "90", "30s", "5m", "2h" or "1d" into seconds.
+ */
+static std::optional<u64> parseDuration(const std::string& value)
+{
+    static const std::pair<char, u64> units[] = {{'s', 1}, {'m', 60}, {'h', 60 * 60}, {'d', 24 * 60 * 60}};
+
+    usize digits = value.find_first_not_of("0123456789");
+    if (value.empty() || digits == 0 || (digits != std::string::npos && digits != value.size() - 1) || value.size() > 12)
+        return std::nullopt;
+
+    u64 amount = std::strtoull(value.c_str(), nullptr, 10);
+    if (digits == std::string::npos)
+        return amount;
+
+    for (const auto& [unit, seconds] : units) {
+        if (value.back() == unit)
+            return amount * seconds;
+    }
+    return std::nullopt;
+}
+
+static bool isValidOption(const proto::CommandType type, const std::string& arg)
+{
+    switch (type) {
+    case proto::CommandType::RESTART:
+        return arg == ROLLING_OPTION;
+    case proto::CommandType::TAIL:
+        return arg == STDERR_OPTION || arg == FOLLOW_OPTION || arg == FOLLOW_SHORT ||
+               (arg.rfind(BYTES_OPTION, 0) == 0 && arg.size() > sizeof(BYTES_OPTION) - 1 &&
+                arg.find_first_not_of("0123456789", sizeof(BYTES_OPTION) - 1) == std::string::npos);
+    case proto::CommandType::LOGS:
+        return arg.rfind(SINCE_OPTION, 0) == 0 && parseDuration(arg.substr(sizeof(SINCE_OPTION) - 1)).has_value();
+    default:
+        return false;
+    }
+}
+
 static const char* commandTypeEnumToString(const proto::CommandType type)
 {
     switch (type) {
@@ -60,6 +113,10 @@ static const char* commandTypeEnumToString(const proto::CommandType type)
         return "reload";
     case proto::CommandType::TERMINATE:
         return "terminate";
+    case proto::CommandType::TAIL:
+        return "tail";
+    case proto::CommandType::LOGS:
+        return "logs";
     default:
         return "invalid";
     }
@@ -70,9 +127,22 @@ std::optional<proto::CommandResponse> Server::parseCommand(const proto::Command&
 {
     proto::CommandResponse error_response;
     const std::string      cmd_str  = commandTypeEnumToString(cmd.type());
-    const auto             arg_size = cmd.args().size();
+    auto                   arg_size = cmd.args().size();
+
+    // options are not counted as job arguments
+    for (const std::string& arg : cmd.args()) {
+        if (!isOption(arg))
+            continue;
+        if (!isValidOption(cmd.type(), arg)) {
+            error_response.set_status(proto::CommandStatus::ARGUMENT_ERROR);
+            error_response.set_message("Unknown option '" + arg + "' for " + cmd_str + ".");
+            return error_response;
+        }
+        arg_size--;
+    }
 
-    if (cmd.type() == proto::CommandType::START || cmd.type() == proto::CommandType::STOP || cmd.type() == proto::CommandType::RESTART) {
+    if (cmd.type() == proto::CommandType::START || cmd.type() == proto::CommandType::STOP || cmd.type() == proto::CommandType::RESTART ||
+        cmd.type() == proto::CommandType::TAIL || cmd.type() == proto::CommandType::LOGS) {
         if (arg_size == 0) {
             error_response.set_status(proto::CommandStatus::ARGUMENT_ERROR);
             error_response.set_message(PROVIDE_JOB + cmd_str + ".");
@@ -110,7 +180,7 @@ std::optional<proto::CommandResponse> Server::parseCommand(const proto::Command&
     return std::nullopt;
 }
 
-proto::CommandResponse Server::onCommand(proto::Command& cmd)
+proto::CommandResponse Server::onCommand(proto::Command& cmd, OutputFollower& follower)
 {
     proto::CommandResponse   response;
 
@@ -126,14 +196,42 @@ proto::CommandResponse Server::onCommand(proto::Command& cmd)
         return _manager.start(cmd.args(0));
     case proto::CommandType::STOP:
         return _manager.stop(cmd.args(0));
-    case proto::CommandType::RESTART:
-        return _manager.restart(cmd.args(0));
+    case proto::CommandType::RESTART: {
+        auto job     = std::find_if_not(cmd.args().begin(), cmd.args().end(), isOption);
+        bool rolling = std::find(cmd.args().begin(), cmd.args().end(), ROLLING_OPTION) != cmd.args().end();
+
+        return _manager.restart(*job, rolling);
+    }
     case proto::CommandType::STATUS:
         if (cmd.args().size())
             return _manager.status(cmd.args(0));
         return _manager.status();
     case proto::CommandType::RELOAD:
         return _manager.reload();
+    case proto::CommandType::TAIL: {
+        auto  job         = std::find_if_not(cmd.args().begin(), cmd.args().end(), isOption);
+        bool  from_stderr = std::find(cmd.args().begin(), cmd.args().end(), STDERR_OPTION) != cmd.args().end();
+        bool  follow      = false;
+        usize bytes       = DEFAULT_TAIL_BYTES;
+
+        for (const std::string& arg : cmd.args()) {
+            if (arg.rfind(BYTES_OPTION, 0) == 0)
+                bytes = std::strtoull(arg.c_str() + sizeof(BYTES_OPTION) - 1, nullptr, 10);
+            else if (arg == FOLLOW_OPTION || arg == FOLLOW_SHORT)
+                follow = true;
+        }
+        return _manager.tail(*job, from_stderr, bytes, follow ? &follower : nullptr);
+    }
+    case proto::CommandType::LOGS: {
+        auto               job = std::find_if_not(cmd.args().begin(), cmd.args().end(), isOption);
+        std::optional<u64> since;
+
+        for (const std::string& arg : cmd.args()) {
+            if (arg.rfind(SINCE_OPTION, 0) == 0)
+                since = parseDuration(arg.substr(sizeof(SINCE_OPTION) - 1));
+        }
+        return _manager.logs(*job, since);
+    }
     case proto::CommandType::TERMINATE:
         response.set_status(proto::CommandStatus::OK);
         response.set_message("Successfully started the termination sequence");
@@ -0,0 +1,56 @@
+#include <taskmasterd/include/jobs/CircuitBreaker.hpp>
+
+#include <logger/include/Logger.hpp>
+
+namespace taskmasterd
+{
+CircuitBreaker::CircuitBreaker(const JobConfig::Breaker& config, std::function<void()> on_close)
+    : _config(config)
+    , _state(State::CLOSED)
+    , _cooldown(config.cooldown, std::bind(&CircuitBreaker::onCooldown, this))
+    , _on_close(on_close)
+{
+}
+
+bool CircuitBreaker::allowRestart()
+{
+    if (_state == State::OPEN)
+        return false;
+
+    // a threshold of 0 disables the breaker
+    if (_config.threshold == 0)
+        return true;
+
+    Clock::time_point now = Clock::now();
+
+    // forget the restarts that left the window
+    while (!_restarts.empty() && now - _restarts.front() >= std::chrono::seconds(_config.window))
+        _restarts.pop_front();
+    _restarts.push_back(now);
+
+    if (_restarts.size() <= static_cast<usize>(_config.threshold))
+        return true;
+
+    _state     = State::OPEN;
+    _closes_at = std::chrono::system_clock::now() + std::chrono::seconds(_config.cooldown);
+    _restarts.clear();
+    _cooldown.start();
+
+    return false;
+}
+
+void CircuitBreaker::reset()
+{
+    _cooldown.stop();
+    _restarts.clear();
+    _state = State::CLOSED;
+}
+
+void CircuitBreaker::onCooldown()
+{
+    LOG_INFO("Circuit breaker closed after a cooldown of " + std::to_string(_config.cooldown) + " seconds");
+
+    _state = State::CLOSED;
+    _on_close();
+}
+} // namespace taskmasterd
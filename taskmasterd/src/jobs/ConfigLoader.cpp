@@ -0,0 +1,350 @@
+#include <taskmasterd/include/jobs/ConfigLoader.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <glob.h>
+#include <iterator>
+#include <stdexcept>
+#include <string.h>
+
+#include <logger/include/Logger.hpp>
+#include <proto/taskmaster.pb.h>
+#include <taskmasterd/include/core/Hasher.hpp>
+
+namespace taskmasterd
+{
+ConfigLoader::ConfigLoader(const std::string& path, const std::string& snapshot_path)
+    : _path(path)
+    , _snapshot_path(snapshot_path)
+    , _parsed_files(0)
+    , _dirty(false)
+{
+    if (!_snapshot_path.empty())
+        readSnapshot();
+}
+
+std::string ConfigLoader::getSnapshotPath()
+{
+    const char* path = std::getenv("TASKMASTERD_SNAPSHOT");
+
+    return path != nullptr ? path : "";
+}
+
+ConfigLoader::ConfigMap ConfigLoader::load()
+{
+    std::unordered_map<std::string, File>        files;
+    std::unordered_map<std::string, std::string> origins;
+    ConfigMap                                    configs;
+
+    _warnings.clear();
+    _parsed_files = 0;
+
+    const File&              main  = getFile(files, _path, true);
+    std::vector<std::string> paths = resolveIncludes(main.includes);
+
+    for (const std::string& path : paths)
+        getFile(files, path, false);
+
+    paths.insert(paths.begin(), _path);
+    for (const std::string& path : paths) {
+        const std::vector<std::string>& warnings = files.at(path).warnings;
+
+        _warnings.insert(_warnings.end(), warnings.begin(), warnings.end());
+        for (const auto& [name, config] : files.at(path).configs) {
+            auto [origin, inserted] = origins.emplace(name, path);
+
+            if (!inserted) {
+                _warnings.push_back("Duplicate job name '" + name + "' in " + path + ", already defined in " + origin->second);
+                LOG_WARNING(_warnings.back());
+                continue;
+            }
+            configs.emplace(name, config);
+        }
+    }
+
+    checkDependencies(configs);
+
+    // files that are not included anymore drop out of the cache
+    if (files.size() != _files.size())
+        _dirty = true;
+    _files = std::move(files);
+
+    if (_dirty && !_snapshot_path.empty())
+        writeSnapshot();
+
+    return configs;
+}
+
+void ConfigLoader::checkDependencies(const ConfigMap& configs)
+{
+    std::unordered_map<std::string, u32>                      pending; // dependencies that are not resolved yet
+    std::unordered_map<std::string, std::vector<std::string>> dependents;
+    std::vector<std::string>                                  ready;
+
+    for (const auto& [name, config] : configs) {
+        for (const std::string& dependency : config.depends_on) {
+            if (configs.find(dependency) == configs.end())
+                throw std::runtime_error("Job " + name + " depends on unknown job " + dependency);
+            dependents[dependency].push_back(name);
+        }
+        pending[name] = config.depends_on.size();
+        if (config.depends_on.empty())
+            ready.push_back(name);
+    }
+
+    // resolve the jobs level by level, the jobs that are left over are part of or wait for a cycle
+    usize resolved = 0;
+    u32   levels   = 0;
+    while (!ready.empty()) {
+        std::vector<std::string> next;
+
+        for (const std::string& name : ready) {
+            for (const std::string& dependent : dependents[name]) {
+                if (--pending[dependent] == 0)
+                    next.push_back(dependent);
+            }
+        }
+        resolved += ready.size();
+        levels++;
+        ready = std::move(next);
+    }
+
+    if (resolved == configs.size()) {
+        LOG_DEBUG("Jobs start in " + std::to_string(levels) + " dependency levels");
+        return;
+    }
+
+    // every job that is left has an unresolved dependency, following those leads into the cycle
+    std::string start;
+    for (const auto& [name, count] : pending) {
+        if (count != 0 && (start.empty() || name < start))
+            start = name;
+    }
+
+    std::unordered_map<std::string, usize> seen;
+    std::vector<std::string>               path;
+    std::string                            current = start;
+    while (seen.find(current) == seen.end()) {
+        seen.emplace(current, path.size());
+        path.push_back(current);
+
+        const std::vector<std::string>& dependencies = configs.at(current).depends_on;
+        current = *std::find_if(dependencies.begin(), dependencies.end(), [&pending](const std::string& name) { return pending.at(name) != 0; });
+    }
+
+    std::string cycle;
+    for (usize i = seen.at(current); i < path.size(); i++)
+        cycle += path[i] + " -> ";
+    throw std::runtime_error("Dependency cycle between jobs: " + cycle + current);
+}
+
+const ConfigLoader::File& ConfigLoader::getFile(std::unordered_map<std::string, File>& files, const std::string& path, bool main)
+{
+    struct stat info;
+
+    if (stat(path.c_str(), &info) == -1)
+        throw std::runtime_error("Failed to read config file " + path + ": " + strerror(errno));
+
+    // a file that did not change since it was checked last is taken from the cache without reading it
+    auto cached = _files.find(path);
+    if (cached != _files.end() && cached->second.verified && isSame(cached->second, info))
+        return files.emplace(path, cached->second).first->second;
+
+    std::ifstream stream(path, std::ios::binary);
+    std::string   content((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+    if (stream.bad())
+        throw std::runtime_error("Failed to read config file " + path);
+
+    Hasher hasher;
+    hasher.add(std::string_view(content));
+
+    // a file that was touched or copied, or comes from the snapshot, only has to be parsed when its content changed
+    if (cached != _files.end() && cached->second.hash == hasher.get()) {
+        File file = cached->second;
+
+        if (!isSame(file, info))
+            _dirty = true;
+        file.inode    = info.st_ino;
+        file.size     = info.st_size;
+        file.mtime    = info.st_mtim;
+        file.verified = true;
+        return files.emplace(path, std::move(file)).first->second;
+    }
+
+    LOG_DEBUG("Parsing config file " + path);
+    _parsed_files++;
+    _dirty = true;
+
+    File file{info.st_ino, info.st_size, info.st_mtim, hasher.get(), true, {}, {}, {}};
+
+    YAML::Node root;
+    try {
+        root = YAML::Load(content);
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Failed to parse config file " + path + ": " + e.what());
+    }
+
+    YAML::Node jobs     = root["jobs"];
+    YAML::Node includes = root["include"];
+
+    if (main && includes.IsDefined()) {
+        if (includes.IsScalar())
+            file.includes.push_back(includes.as<std::string>());
+        else
+            file.includes = includes.as<std::vector<std::string>>();
+    }
+
+    if (jobs.IsDefined()) {
+        file.configs = JobConfig::getJobConfigs(jobs);
+    } else if (main && !includes.IsDefined()) {
+        LOG_FATAL("ERROR: No 'jobs' node found in the configuration file.");
+        throw std::runtime_error("ERROR: No 'jobs' node found in the configuration file.");
+    } else if (!main) {
+        file.warnings.push_back("No 'jobs' node found in " + path);
+        LOG_WARNING(file.warnings.back());
+    }
+
+    return files.emplace(path, std::move(file)).first->second;
+}
+
+bool ConfigLoader::isSame(const File& file, const struct stat& info)
+{
+    return file.inode == info.st_ino && file.size == info.st_size && file.mtime.tv_sec == info.st_mtim.tv_sec && file.mtime.tv_nsec == info.st_mtim.tv_nsec;
+}
+
+void ConfigLoader::readSnapshot()
+{
+    std::ifstream stream(_snapshot_path, std::ios::binary);
+    if (!stream.is_open()) {
+        LOG_DEBUG("No config snapshot at " + _snapshot_path);
+        return;
+    }
+
+    proto::ConfigSnapshot snapshot;
+    if (!snapshot.ParseFromIstream(&stream) || snapshot.version() != SNAPSHOT_VERSION) {
+        LOG_WARNING("Ignoring the config snapshot " + _snapshot_path + ": invalid or written by another version");
+        return;
+    }
+
+    for (const proto::ConfigFileSnapshot& entry : snapshot.files()) {
+        // the files are checked against their hash on the first load
+        File file{static_cast<ino_t>(entry.inode()),
+                  static_cast<off_t>(entry.size()),
+                  {entry.mtime_sec(), entry.mtime_nsec()},
+                  entry.hash(),
+                  false,
+                  {},
+                  {entry.includes().begin(), entry.includes().end()},
+                  {entry.warnings().begin(), entry.warnings().end()}};
+
+        try {
+            for (const proto::JobConfigSnapshot& job : entry.jobs())
+                file.configs.emplace(job.name(), JobConfig::fromSnapshot(job));
+        } catch (const std::exception& e) {
+            LOG_WARNING("Ignoring the config snapshot " + _snapshot_path + ": " + e.what());
+            _files.clear();
+            return;
+        }
+
+        _files.emplace(entry.path(), std::move(file));
+    }
+
+    LOG_INFO("Loaded the config snapshot " + _snapshot_path + " with " + std::to_string(_files.size()) + " files");
+}
+
+void ConfigLoader::writeSnapshot()
+{
+    proto::ConfigSnapshot snapshot;
+
+    snapshot.set_version(SNAPSHOT_VERSION);
+    for (const auto& [path, file] : _files) {
+        proto::ConfigFileSnapshot* entry = snapshot.add_files();
+
+        entry->set_path(path);
+        entry->set_inode(file.inode);
+        entry->set_size(file.size);
+        entry->set_mtime_sec(file.mtime.tv_sec);
+        entry->set_mtime_nsec(file.mtime.tv_nsec);
+        entry->set_hash(file.hash);
+        for (const auto& [name, config] : file.configs)
+            config.toSnapshot(*entry->add_jobs());
+        for (const std::string& include : file.includes)
+            entry->add_includes(include);
+        for (const std::string& warning : file.warnings)
+            entry->add_warnings(warning);
+    }
+
+    // write next to the snapshot and rename, a daemon that starts meanwhile never sees half a snapshot
+    std::string   temporary = _snapshot_path + ".tmp";
+    std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+
+    if (!stream.is_open() || !snapshot.SerializeToOstream(&stream) || !stream.flush()) {
+        LOG_WARNING("Failed to write the config snapshot " + temporary);
+        std::remove(temporary.c_str());
+        return;
+    }
+    stream.close();
+
+    if (std::rename(temporary.c_str(), _snapshot_path.c_str()) == -1) {
+        LOG_WARNING("Failed to write the config snapshot " + _snapshot_path + ": " + strerror(errno));
+        std::remove(temporary.c_str());
+        return;
+    }
+    _dirty = false;
+}
+
+std::vector<std::string> ConfigLoader::getPatterns() const
+{
+    std::vector<std::string> patterns{_path};
+
+    auto main = _files.find(_path);
+    if (main != _files.end()) {
+        for (const std::string& pattern : main->second.includes)
+            patterns.push_back(resolvePattern(pattern));
+    }
+
+    return patterns;
+}
+
+std::string ConfigLoader::resolvePattern(const std::string& pattern) const
+{
+    std::filesystem::path path = pattern;
+
+    if (path.is_relative())
+        path = (std::filesystem::path(_path).parent_path() / path).lexically_normal();
+
+    return path.string();
+}
+
+std::vector<std::string> ConfigLoader::resolveIncludes(const std::vector<std::string>& patterns) const
+{
+    std::vector<std::string> paths;
+
+    for (const std::string& pattern : patterns) {
+        std::string full = resolvePattern(pattern);
+
+        glob_t matches;
+        i32    result = glob(full.c_str(), 0, nullptr, &matches);
+
+        if (result == 0) {
+            for (usize i = 0; i < matches.gl_pathc; i++)
+                paths.push_back(matches.gl_pathv[i]);
+        } else if (result != GLOB_NOMATCH) {
+            globfree(&matches);
+            throw std::runtime_error("Failed to expand include pattern " + pattern);
+        }
+        globfree(&matches);
+    }
+
+    // a file matched by more than one pattern is only loaded once
+    std::sort(paths.begin(), paths.end());
+    paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+    paths.erase(std::remove(paths.begin(), paths.end(), _path), paths.end());
+
+    return paths;
+}
+} // namespace taskmasterd
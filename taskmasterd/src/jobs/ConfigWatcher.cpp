@@ -0,0 +1,112 @@
+#include <taskmasterd/include/jobs/ConfigWatcher.hpp>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fnmatch.h>
+#include <stdexcept>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <logger/include/Logger.hpp>
+#include <taskmasterd/include/core/EventManager.hpp>
+
+namespace taskmasterd
+{
+namespace
+{
+// a file is complete once it is closed after writing or moved into place, deletions change the config as well
+constexpr u32 WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE;
+} // namespace
+
+ConfigWatcher::ConfigWatcher(std::function<void()> on_change, TimerWheel::Duration debounce)
+    : ipc::FileDescriptor(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+    , _on_change(std::move(on_change))
+    , _debounce(debounce, [this]() { _on_change(); })
+{
+    if (_fd == -1)
+        throw std::runtime_error("Failed to create the inotify instance: " + std::string(strerror(errno)));
+
+    EventManager::getInstance().registerEvent(*this, std::bind(&ConfigWatcher::onEvent, this), nullptr);
+}
+
+ConfigWatcher::~ConfigWatcher()
+{
+    if (_fd != -1)
+        EventManager::getInstance().unregisterEvent(*this);
+}
+
+bool ConfigWatcher::isEnabled()
+{
+    const char* watch = std::getenv("TASKMASTERD_WATCH");
+
+    return watch != nullptr && std::string(watch) == "1";
+}
+
+void ConfigWatcher::watch(const std::vector<std::string>& patterns)
+{
+    std::unordered_map<i32, std::vector<std::string>> watches;
+
+    for (const std::string& pattern : patterns) {
+        std::filesystem::path path      = pattern;
+        std::string           directory = path.has_parent_path() ? path.parent_path().string() : ".";
+
+        // the same directory reached through another path returns the same watch descriptor
+        i32 wd = inotify_add_watch(_fd, directory.c_str(), WATCH_MASK);
+        if (wd == -1) {
+            LOG_WARNING("Failed to watch config directory " + directory + ": " + strerror(errno));
+            continue;
+        }
+        watches[wd].push_back(path.filename().string());
+    }
+
+    for (const auto& [wd, names] : _watches) {
+        if (watches.find(wd) == watches.end())
+            inotify_rm_watch(_fd, wd);
+    }
+    _watches = std::move(watches);
+}
+
+void ConfigWatcher::onEvent()
+{
+    alignas(struct inotify_event) char buffer[4096];
+    bool                               changed = false;
+
+    while (true) {
+        isize size = read(_fd, buffer, sizeof(buffer));
+
+        if (size == -1 && errno == EINTR)
+            continue;
+        if (size <= 0)
+            break;
+
+        for (char* ptr = buffer; ptr < buffer + size;) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(ptr);
+
+            if (event->mask & IN_IGNORED)
+                _watches.erase(event->wd);
+            else if (event->mask & IN_Q_OVERFLOW || (event->len > 0 && isWatched(event->wd, event->name)))
+                changed = true;
+
+            ptr += sizeof(struct inotify_event) + event->len;
+        }
+    }
+
+    // every new event pushes the reload back, a burst of writes results in a single reload
+    if (changed)
+        _debounce.start();
+}
+
+bool ConfigWatcher::isWatched(i32 wd, const char* name) const
+{
+    auto it = _watches.find(wd);
+    if (it == _watches.end())
+        return false;
+
+    for (const std::string& pattern : it->second) {
+        if (fnmatch(pattern.c_str(), name, FNM_PERIOD) == 0)
+            return true;
+    }
+    return false;
+}
+} // namespace taskmasterd
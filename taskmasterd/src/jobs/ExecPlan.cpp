@@ -0,0 +1,172 @@
+#include <taskmasterd/include/jobs/ExecPlan.hpp>
+
+#include <cstdlib>
+#include <string.h>
+#include <string_view>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+#include <logger/include/Logger.hpp>
+#include <taskmasterd/include/jobs/NotifySocket.hpp>
+
+namespace taskmasterd
+{
+namespace
+{
+// the plans by spawn fingerprint
+std::unordered_map<u64, std::shared_ptr<const ExecPlan>> plans;
+
+constexpr std::string_view NOTIFY_VARIABLE = "NOTIFY_SOCKET";
+
+/**
+ * @brief Check if a file is an ELF binary, scripts cannot be executed through an O_CLOEXEC fd
+ * because their interpreter opens them again by path.
+ */
+bool isElf(i32 fd)
+{
+    char magic[4];
+
+    return pread(fd, magic, sizeof(magic), 0) == sizeof(magic) && memcmp(magic, "\x7f" "ELF", sizeof(magic)) == 0;
+}
+} // namespace
+
+std::shared_ptr<const ExecPlan> ExecPlan::get(const JobConfig& config)
+{
+    auto it = plans.find(config.spawn_fingerprint);
+    if (it != plans.end())
+        return it->second;
+
+    std::shared_ptr<const ExecPlan> plan(new ExecPlan(config));
+
+    // a command that was not found is looked up again for the next job, it may be installed by then
+    if (strchr(plan->getPath(), '/') != nullptr)
+        plans.emplace(config.spawn_fingerprint, plan);
+    return plan;
+}
+
+void ExecPlan::prune()
+{
+    std::erase_if(plans, [](const auto& entry) { return entry.second.use_count() == 1; });
+}
+
+ExecPlan::ExecPlan(const JobConfig& config)
+    : _request{}
+    , _device(0)
+    , _inode(0)
+{
+    std::string path = resolve(config);
+
+    // a process that notifies finds the socket of the daemon in NOTIFY_SOCKET, it replaces a variable of the job
+    std::string notify = config.notify ? std::string(NOTIFY_VARIABLE) + "=" + NotifySocket::getInstance().getAddress() : "";
+
+    // the pointer arrays go first so they are aligned, the strings follow
+    usize pointers = config.argv.size() + 1 + config.env.size() + 1 + 1;
+    usize size     = pointers * sizeof(char*) + path.size() + 1 + config.working_dir.size() + 1 + notify.size() + 1;
+
+    for (const std::string& arg : config.argv)
+        size += arg.size() + 1;
+    for (const auto& [key, value] : config.env)
+        size += key.size() + 1 + value.size() + 1;
+
+    _arena.reset(new char[size]);
+
+    char** table  = reinterpret_cast<char**>(_arena.get());
+    char*  cursor = _arena.get() + pointers * sizeof(char*);
+    auto   copy   = [&cursor](std::string_view value, char end = '\0') {
+        char* start = cursor;
+
+        memcpy(cursor, value.data(), value.size());
+        cursor += value.size();
+        *cursor++ = end;
+        return start;
+    };
+
+    char** argv = table;
+    for (const std::string& arg : config.argv)
+        *table++ = copy(arg);
+    *table++ = nullptr;
+
+    char** env = table;
+    for (const auto& [key, value] : config.env) {
+        if (config.notify && key == NOTIFY_VARIABLE)
+            continue;
+        // key=value, the '=' takes the place of the terminator of the key
+        *table++ = copy(key, '=');
+        copy(value);
+    }
+    if (config.notify)
+        *table++ = copy(notify);
+    *table++ = nullptr;
+
+    // the output files are opened by the daemon, the process gets the pipes of its output streams
+    _request.path        = copy(path);
+    _request.argv        = argv;
+    _request.env         = env;
+    _request.working_dir = copy(config.working_dir);
+    _request.umask       = config.umask;
+
+    // only an absolute path keeps pointing at the same binary, a relative one depends on the working directory
+    struct stat info;
+
+    if (path[0] == '/')
+        _binary = ipc::FileDescriptor(open(path.c_str(), O_PATH | O_CLOEXEC));
+    if (_binary.getFd() != -1 && fstat(_binary.getFd(), &info) == 0 && S_ISREG(info.st_mode)) {
+        // O_PATH fds cannot be read, check the header through a regular fd
+        ipc::FileDescriptor file(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+
+        if (file.getFd() != -1 && isElf(file.getFd())) {
+            _device          = info.st_dev;
+            _inode           = info.st_ino;
+            _request.exec_fd = _binary.getFd();
+        }
+    }
+    if (_request.exec_fd == -1)
+        _binary.close();
+
+    LOG_DEBUG("Built exec plan for job " + config.name + ": " + path + (_request.exec_fd != -1 ? " (execveat)" : ""));
+}
+
+std::string ExecPlan::resolve(const JobConfig& config)
+{
+    const std::string& name = config.argv[0];
+
+    if (name.find('/') != std::string::npos)
+        return name;
+
+    auto        it    = config.env.find("PATH");
+    const char* value = it != config.env.end() ? it->second.c_str() : std::getenv("PATH");
+    std::string_view search = value != nullptr ? value : "/usr/local/bin:/usr/bin:/bin";
+
+    while (true) {
+        usize            end       = search.find(':');
+        std::string_view directory = search.substr(0, end);
+        std::string      candidate = (directory.empty() ? std::string(".") : std::string(directory)) + "/" + name;
+        struct stat      info;
+
+        if (stat(candidate.c_str(), &info) == 0 && S_ISREG(info.st_mode) && access(candidate.c_str(), X_OK) == 0)
+            return candidate;
+
+        if (end == std::string_view::npos)
+            break;
+        search.remove_prefix(end + 1);
+    }
+
+    LOG_WARNING("Command " + name + " of job " + config.name + " was not found in PATH");
+    return name;
+}
+
+SpawnRequest ExecPlan::getRequest(pid_t pgid) const
+{
+    SpawnRequest request = _request;
+    struct stat  info;
+
+    request.pgid = pgid;
+
+    // a binary that was replaced on disk, by an upgrade for example, is executed by its path again
+    if (request.exec_fd != -1 && (stat(request.path, &info) != 0 || info.st_dev != _device || info.st_ino != _inode))
+        request.exec_fd = -1;
+
+    return request;
+}
+} // namespace taskmasterd
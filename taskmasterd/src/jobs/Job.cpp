@@ -5,6 +5,7 @@
 #include <bits/stdc++.h>
 #include <cmath>
 #include <memory>
+#include <random>
 #include <string>
 #include <taskmasterd/include/core/EventManager.hpp>
 #include <taskmasterd/include/jobs/Job.hpp>
@@ -16,41 +17,26 @@ namespace taskmasterd
 Job::Job(const JobConfig& config, JobManager& manager)
     : _config(config)
     , _manager(manager)
+    , _plan(ExecPlan::get(config))
     , _pgid(0)
+    , _state_counts{}
+    , _scheduled_starts(0)
+    , _breaker(config.breaker, std::bind(&Job::onBreakerClosed, this))
+    , _rolling_next(0)
 {
-    parseArguments(config);
-    parseEnvironment(config);
-
     _state = State::EMPTY;
 }
 
-void Job::parseArguments(const JobConfig& config)
-{
-    // Prepare argv and env for execve
-    _arg_store = split_shell(config.cmd);
-    _argv.reserve(_arg_store.size() + 1);
-    for (auto& arg : _arg_store) {
-        _argv.push_back(arg.c_str());
-    }
-    _argv.push_back(nullptr);
-}
-
-void Job::parseEnvironment(const JobConfig& config)
-{
-
-    _env.reserve(config.env.size() + 1);
-    _env_store.reserve(config.env.size());
-    for (auto& [key, value] : _config.env) {
-        _env_store.push_back(key + "=" + value);
-        _env.push_back(_env_store.back().c_str());
-    }
-    _env.push_back(nullptr);
-}
-
 void Job::start()
 {
     LOG_DEBUG("Start called called for process" + std::to_string(static_cast<i32>(_state)));
 
+    // starting a job by hand overrides the circuit breaker
+    if (_breaker.getState() == CircuitBreaker::State::OPEN) {
+        LOG_INFO("Circuit breaker of job " + _config.name + " closed by a start request");
+        _breaker.reset();
+    }
+
     switch (_state) {
     case State::STOPPING:
         restartProcesses();
@@ -62,7 +48,8 @@ void Job::start()
         startProcesses();
         break;
     default:
-        break;
+        // a job that is up stays in its state, the manager waits for it to be RUNNING
+        return;
     }
 
     _state = State::STARTING;
@@ -75,30 +62,182 @@ void Job::startProcesses()
         _processes.reserve(_config.numprocs);
 
     for (i32 i = 0; i < _config.numprocs; i++) {
-        std::string proc_name = _config.name + "_" + std::to_string(i);
+        Process& proc = addProcess();
 
-        std::unique_ptr<Process>& proc = _processes.emplace_back(std::make_unique<Process>(proc_name, _pgid, *this));
+        startProcess(proc);
+    }
+}
+
+Process& Job::addProcess()
+{
+    std::string proc_name = _config.name + "_" + std::to_string(_processes.size());
+
+    std::unique_ptr<Process>& proc = _processes.emplace_back(std::make_unique<Process>(proc_name, _processes.size(), *this));
+    _state_counts[static_cast<usize>(Process::State::STOPPED)]++;
+
+    return *proc;
+}
+
+// states from which a start request starts the process again
+static bool allowsStart(Process::State state)
+{
+    return state == Process::State::STOPPED || state == Process::State::EXITED || state == Process::State::BACKOFF || state == Process::State::FATAL;
+}
+
+void Job::restartProcesses()
+{
+    // surplus processes of a smaller numprocs are waiting to be removed
+    for (u32 i = 0; i < std::min<u32>(_processes.size(), _config.numprocs); i++) {
+        Process& proc = *_processes[i];
+
+        proc.resetRestarts();
+        if (allowsStart(proc.getState()))
+            startProcess(proc);
+    }
+}
+
+void Job::applyConfig(const JobConfig& config)
+{
+    u32 old_numprocs = _config.numprocs;
+
+    _config = config;
+    _breaker.setConfig(config.breaker);
+    for (const std::unique_ptr<Process>& proc : _processes)
+        proc->setLogRotation(config);
+
+    if (static_cast<u32>(config.numprocs) == old_numprocs)
+        return;
+
+    LOG_INFO("Scaling job " + _config.name + " from " + std::to_string(old_numprocs) + " to " + std::to_string(config.numprocs) + " processes");
+
+    if (isRolling())
+        abortRollingRestart("the job was resized");
+
+    // a job that never started creates its processes when it starts
+    if (_state == State::EMPTY)
+        return;
+
+    bool active = _state == State::STARTING || _state == State::RUNNING;
+
+    // processes left over from a previous shrink are reused first
+    for (u32 i = old_numprocs; i < std::min<u32>(_processes.size(), config.numprocs); i++) {
+        if (active && allowsStart(_processes[i]->getState()))
+            startProcess(*_processes[i]);
+    }
+
+    while (_processes.size() < static_cast<u32>(config.numprocs)) {
+        Process& proc = addProcess();
+        if (active)
+            startProcess(proc);
+    }
+
+    if (active && static_cast<u32>(config.numprocs) > old_numprocs)
+        _state = State::STARTING;
+
+    // the surplus processes with the highest index are stopped and removed by trimProcesses
+    for (u32 i = config.numprocs; i < _processes.size(); i++) {
+        Process& proc = *_processes[i];
+
+        if (proc.getState() != Process::State::STOPPING && proc.getState() != Process::State::STOPPED)
+            proc.stop(_config.stop_time, _config.stop_signal);
+    }
+
+    trimProcesses();
+}
+
+void Job::trimProcesses()
+{
+    while (_processes.size() > static_cast<u32>(_config.numprocs) && _processes.back()->getState() == Process::State::STOPPED) {
+        _state_counts[static_cast<usize>(Process::State::STOPPED)]--;
+        _processes.pop_back();
+    }
+
+    // the remaining processes may all be running now
+    if (_state == State::STARTING && allProcessesInStates({Process::State::RUNNING})) {
+        _state = State::RUNNING;
+        _manager.onRunning(_config.name);
+    }
+}
+
+void Job::startProcess(Process& proc)
+{
+    proc.enqueue(_config.priority);
+}
+
+void Job::launchProcess(Process& proc)
+{
+    // the first process leads the process group of the job, the others join it
+    pid_t pgid = &proc == _processes.front().get() ? 0 : _pgid;
+
+    proc.start(*_plan, _config, pgid);
+    if (_pgid == 0)
+        _pgid = proc.getPid();
+}
+
+void Job::onLaunchFailed(Process& proc)
+{
+    proc.fail();
+    if (inRollingBatch(proc))
+        abortRollingRestart(proc.getName() + " failed to start");
+    if (allProcessesIdle())
+        _state = State::STOPPED;
+}
 
-        proc->start(_argv[0], const_cast<char* const*>(_argv.data()), const_cast<char* const*>(_env.data()), _config);
-        // Set the job's pgid to the first process's pid
-        if (_pgid == 0) {
-            _pgid = proc->getPid();
+bool Job::scheduleRestart(Process& proc)
+{
+    static std::mt19937 generator(std::random_device{}());
+
+    bool was_open = _breaker.getState() == CircuitBreaker::State::OPEN;
+    if (!_breaker.allowRestart()) {
+        if (!was_open) {
+            LOG_WARNING("Circuit breaker of job " + _config.name + " opened, more than " + std::to_string(_config.breaker.threshold) +
+                        " restarts within " + std::to_string(_config.breaker.window) + " seconds");
+
+            // the processes that wait for a restart are parked as well
+            for (auto& other : _processes) {
+                if (other->getNextAttempt().has_value())
+                    other->park();
+            }
         }
+        proc.park();
+        return false;
     }
+
+    const JobConfig::Backoff& backoff = _config.backoff;
+
+    // the first restart waits base seconds, every following restart waits factor times longer
+    double delay = std::min(backoff.max, backoff.base * std::pow(backoff.factor, std::max(proc.getRestarts() - 1, 0)));
+
+    // spread the restarts of processes that crashed together
+    std::uniform_real_distribution<double> jitter(-backoff.jitter, backoff.jitter);
+    delay *= 1 + jitter(generator);
+
+    auto duration = std::chrono::duration_cast<TimerWheel::Duration>(std::chrono::duration<double>(delay));
+    proc.scheduleStart(duration, [this, &proc]() { startProcess(proc); });
+    return true;
 }
 
-void Job::restartProcesses()
+void Job::onBreakerClosed()
 {
-    for (auto& proc : _processes) {
+    bool restarted = false;
 
+    // the parked processes get a fresh set of retries, the ones that used up their retries or failed to spawn stay FATAL
+    for (auto& proc : _processes) {
+        if (proc->getState() != Process::State::FATAL || !proc->isParked())
+            continue;
         proc->resetRestarts();
-        if (proc->getState() == Process::State::STOPPED || proc->getState() == Process::State::EXITED || proc->getState() == Process::State::BACKOFF)
-            proc->start(_argv[0], const_cast<char* const*>(_argv.data()), const_cast<char* const*>(_env.data()), _config);
+        startProcess(*proc);
+        restarted = true;
     }
+
+    if (restarted)
+        _state = State::STARTING;
 }
 
 void Job::stop()
 {
+    if (isRolling())
+        abortRollingRestart("the job is stopped");
 
     switch (_state) {
         case State::STOPPING:
@@ -113,24 +252,44 @@ void Job::stop()
             _state = State::STOPPING;
             for (auto& proc : _processes)
                 proc->stop(_config.stop_time, _config.stop_signal);
+
+            // no process had to be signalled, like stopped surplus processes that wait for trimProcesses
+            if (_state == State::STOPPING && allProcessesInStates({Process::State::STOPPED})) {
+                _state = State::STOPPED;
+                _manager.onStop(_config.name);
+            }
             break;
     }   
 }
 
-bool Job::allProcessesInStates(std::vector<Process::State> state)
+bool Job::allProcessesIdle() const
 {
-    for (auto& proc : _processes) {
-        if (std::find(state.begin(), state.end(), proc->getState()) == state.end())
-            return false;
-    }
-    return true;
+    return _scheduled_starts == 0 && allProcessesInStates({Process::State::EXITED, Process::State::BACKOFF, Process::State::STOPPED, Process::State::FATAL});
+}
+
+bool Job::allProcessesInStates(std::initializer_list<Process::State> states) const
+{
+    u32 count = 0;
+
+    for (Process::State state : states)
+        count += _state_counts[static_cast<usize>(state)];
+    return count == _processes.size();
+}
+
+void Job::onProcessStateChange(Process::State previous, Process::State current)
+{
+    _state_counts[static_cast<usize>(previous)]--;
+    _state_counts[static_cast<usize>(current)]++;
 }
 
 void Job::onExit(Process& proc, i32 status_code)
 {
     if (proc.getRestarts() == _config.start_retries) {
         LOG_WARNING("Process stopped max retries reached " + proc.getName());
-        if (allProcessesInStates({Process::State::EXITED, Process::State::BACKOFF, Process::State::STOPPED}))
+        proc.fail();
+        if (inRollingBatch(proc))
+            abortRollingRestart(proc.getName() + " failed to start");
+        if (allProcessesIdle())
             _state = State::STOPPED;
         return;
     }
@@ -146,23 +305,94 @@ void Job::onExit(Process& proc, i32 status_code)
         break;
     case JobConfig::RestartPolicy::ALWAYS:
         proc.addRestart();
+        if (!scheduleRestart(proc))
+            break;
         _state = State::STARTING;
-        proc.start(_argv[0], const_cast<char* const*>(_argv.data()), const_cast<char* const*>(_env.data()), _config);
         return;
     case JobConfig::RestartPolicy::ON_FAILURE:
         proc.addRestart();
         // if the status code is known its not an unexpected exit
         if (std::find(it_begin, it_end, status_code) != it_end)
             break;
+        if (!scheduleRestart(proc))
+            break;
         _state = State::STARTING;
-        proc.start(_argv[0], const_cast<char* const*>(_argv.data()), const_cast<char* const*>(_env.data()), _config);
         return;
     }
 
-    if (allProcessesInStates({Process::State::EXITED, Process::State::BACKOFF, Process::State::STOPPED}))
+    if (inRollingBatch(proc))
+        abortRollingRestart(proc.getName() + " failed to start");
+
+    if (allProcessesIdle())
         _state = State::STOPPED;
 }
 
+void Job::rollingRestart()
+{
+    LOG_INFO("Rolling restart of job " + _config.name + " in batches of " + std::to_string(_config.rolling_batch) + "%");
+
+    _rolling_next = 0;
+    startRollingBatch();
+}
+
+void Job::startRollingBatch()
+{
+    u32 count = _processes.size();
+    u32 batch = std::max<u32>(1, (count * _config.rolling_batch + 99) / 100);
+    u32 end   = std::min(_rolling_next + batch, count);
+
+    if (_rolling_next == count) {
+        LOG_INFO("Rolling restart of job " + _config.name + " finished");
+        return;
+    }
+
+    for (u32 i = _rolling_next; i < end; i++)
+        _rolling_batch.push_back(_processes[i].get());
+    _rolling_next = end;
+
+    LOG_INFO("Rolling restart of job " + _config.name + ": replacing " + std::to_string(_rolling_batch.size()) + " processes, " +
+             std::to_string(end) + "/" + std::to_string(count));
+
+    // processes that are not alive are started right away, the others once they stopped
+    for (u32 i = end - _rolling_batch.size(); i < end; i++) {
+        Process& proc = *_processes[i];
+
+        proc.resetRestarts();
+        switch (proc.getState()) {
+        case Process::State::STARTING:
+        case Process::State::RUNNING:
+            proc.stop(_config.stop_time, _config.stop_signal);
+            break;
+        case Process::State::STOPPING:
+        case Process::State::QUEUED:
+            break;
+        default:
+            startProcess(proc);
+            break;
+        }
+    }
+}
+
+bool Job::isSurplus(const Process& proc) const
+{
+    auto it = std::find_if(_processes.begin() + _config.numprocs, _processes.end(), [&proc](const auto& other) { return other.get() == &proc; });
+
+    return it != _processes.end();
+}
+
+bool Job::inRollingBatch(const Process& proc) const
+{
+    return std::find(_rolling_batch.begin(), _rolling_batch.end(), &proc) != _rolling_batch.end();
+}
+
+void Job::abortRollingRestart(const std::string& reason)
+{
+    LOG_WARNING("Rolling restart of job " + _config.name + " aborted: " + reason);
+
+    _rolling_batch.clear();
+    _rolling_next = 0;
+}
+
 static char const* processStateEnumToString(Process::State state)
 {
     switch (state) {
@@ -180,6 +410,8 @@ static char const* processStateEnumToString(Process::State state)
         return "STOPPED";
     case Process::State::STOPPING:
         return "STOPPING";
+    case Process::State::QUEUED:
+        return "QUEUED";
     default:
         return "UNKNOWN";
     }
@@ -203,6 +435,15 @@ static char const* jobStateEnumToString(Job::State state)
     }
 }
 
+static std::string formatTime(std::chrono::system_clock::time_point time)
+{
+    std::time_t now = std::chrono::system_clock::to_time_t(time);
+    char        buffer[9];
+
+    std::strftime(buffer, sizeof(buffer), "%H:%M:%S", std::localtime(&now));
+    return buffer;
+}
+
 static std::string formatColumn(std::string name, bool should_concatenate, u32 left_width, u32 right_width)
 {
     std::stringstream stream;
@@ -228,8 +469,8 @@ std::ostream& operator<<(std::ostream& os, const Job& job)
     const u32   max_size      = 20;
     const u32   process_count = job.getProcessCount();
     std::string name          = job.getConfig().name;
-    char const* jobStateStr;
-    char const* processStateStr;
+    std::string jobStateStr;
+    std::string processStateStr;
     u32         left_width;
     u32         right_width;
 
@@ -244,12 +485,28 @@ std::ostream& operator<<(std::ostream& os, const Job& job)
     setFillerWidth(name, left_width, right_width);
     os << formatColumn(name, name.size() > max_size, left_width, right_width);
 
+    // a rolling restart shows its progress instead of the job state
     jobStateStr = jobStateEnumToString(job.getState());
+    if (job.isRolling())
+        jobStateStr = "ROLLING " + std::to_string(job.getRollingProgress()) + "/" + std::to_string(process_count);
     setFillerWidth(jobStateStr, left_width, right_width);
-    os << formatColumn(jobStateStr, strlen(jobStateStr) > max_size, left_width, right_width);
-
-    // Start next line, leaving the proccess name and status empty
-    os << "                      |                      |\n";
+    os << formatColumn(jobStateStr, jobStateStr.size() > max_size, left_width, right_width);
+
+    // Insert the circuit breaker in the process columns, unless it is disabled
+    if (job.getConfig().breaker.threshold == 0) {
+        os << "                      |                      |\n";
+    } else {
+        const CircuitBreaker& breaker = job.getBreaker();
+        bool                  open    = breaker.getState() == CircuitBreaker::State::OPEN;
+        std::string           column  = open ? "breaker: OPEN" : "breaker: CLOSED";
+
+        setFillerWidth(column, left_width, right_width);
+        os << formatColumn(column, false, left_width, right_width);
+
+        column = open ? "until " + formatTime(breaker.getClosesAt()) : "";
+        setFillerWidth(column, left_width, right_width);
+        os << formatColumn(column, false, left_width, right_width) << "\n";
+    }
 
     // Start proccess info printing
     os << "├──────────────────────┼──────────────────────┼──────────────────────┼──────────────────────┤\n";
@@ -266,10 +523,12 @@ std::ostream& operator<<(std::ostream& os, const Job& job)
         setFillerWidth(name, left_width, right_width);
         os << formatColumn(name, name.size() > max_size, left_width, right_width);
 
-        // Insert process state
+        // Insert process state, a pending restart shows the time of the next attempt
         processStateStr = processStateEnumToString(processState);
+        if (current_process->getNextAttempt().has_value())
+            processStateStr += " " + formatTime(current_process->getNextAttempt().value());
         setFillerWidth(processStateStr, left_width, right_width);
-        os << formatColumn(processStateStr, strlen(processStateStr) > max_size, left_width, right_width);
+        os << formatColumn(processStateStr, processStateStr.size() > max_size, left_width, right_width);
 
         // Start next line
         os << "\n";
@@ -282,9 +541,19 @@ std::ostream& operator<<(std::ostream& os, const Job& job)
 
 void Job::onStop(Process& proc)
 {
+    // a process of a rolling restart batch is started again as soon as it stopped
+    if (inRollingBatch(proc)) {
+        startProcess(proc);
+        return;
+    }
+
+    // surplus processes of a smaller numprocs stay stopped until trimProcesses removes them
+    if (_state != State::STOPPING && hasSurplus() && isSurplus(proc))
+        return;
+
     switch (_state) {
     case State::STARTING:
-        proc.start(_argv[0], const_cast<char* const*>(_argv.data()), const_cast<char* const*>(_env.data()), _config);
+        startProcess(proc);
         break;
     case State::STOPPING:
         if (!allProcessesInStates({Process::State::STOPPED}))
@@ -297,10 +566,17 @@ void Job::onStop(Process& proc)
     }
 }
 
-void Job::onProcessSurpassedStartTime()
+void Job::onProcessSurpassedStartTime(Process& proc)
 {
-    if (allProcessesInStates({Process::State::RUNNING})) {
+    if (inRollingBatch(proc)) {
+        _rolling_batch.erase(std::find(_rolling_batch.begin(), _rolling_batch.end(), &proc));
+        if (_rolling_batch.empty())
+            startRollingBatch();
+    }
+
+    if (_state == State::STARTING && allProcessesInStates({Process::State::RUNNING})) {
         _state = State::RUNNING;
+        _manager.onRunning(_config.name);
     }
 }
 
@@ -1,13 +1,62 @@
 #include "logger/include/Logger.hpp"
-#include <filesystem>
-#include <functional>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <proto/taskmaster.pb.h>
+#include <taskmasterd/include/core/Hasher.hpp>
 #include <taskmasterd/include/jobs/JobConfig.hpp>
 
 namespace taskmasterd
 {
+namespace
+{
+// below this amount of jobs per thread starting the threads costs more than it saves
+constexpr usize MIN_JOBS_PER_THREAD = 32;
+
+// the warnings of the job that is parsed on this thread, they are logged in the order of the jobs
+// once all jobs are parsed
+thread_local std::vector<std::string>* t_warnings = nullptr;
+
+void warn(const std::string& message)
+{
+    if (t_warnings != nullptr)
+        t_warnings->push_back(message);
+    else
+        LOG_WARNING(message);
+}
+
+/**
+ * @brief Call task for every index below count, spread over the available cores.
+ */
+template <typename Task> void parallelFor(usize count, const Task& task)
+{
+    usize threads = std::min<usize>(std::max(1U, std::thread::hardware_concurrency()), count / MIN_JOBS_PER_THREAD);
+
+    if (threads <= 1) {
+        for (usize i = 0; i < count; i++)
+            task(i);
+        return;
+    }
+
+    std::atomic<usize> next = 0;
+    auto               work = [&]() {
+        for (usize i = next++; i < count; i = next++)
+            task(i);
+    };
+
+    // the calling thread works along, the others are joined when the pool goes out of scope
+    std::vector<std::jthread> pool;
+    pool.reserve(threads - 1);
+    for (usize i = 1; i < threads; i++)
+        pool.emplace_back(work);
+    work();
+}
+} // namespace
 
 void parseCmd(JobConfig* object, const YAML::Node& config)
 {
@@ -68,6 +117,17 @@ void parseAutoStart(JobConfig* object, const YAML::Node& config)
     object->autostart = config.as<bool>();
 }
 
+void parseNotify(JobConfig* object, const YAML::Node& config)
+{
+    if (!config.IsDefined()) {
+        // by default a process is RUNNING once it stayed up for starttime seconds
+        object->notify = false;
+        return;
+    }
+
+    object->notify = config.as<bool>();
+}
+
 void parseAutoRestart(JobConfig* object, const YAML::Node& config)
 {
     if (!config.IsDefined()) {
@@ -124,6 +184,99 @@ void parseStartTime(JobConfig* object, const YAML::Node& config)
     object->start_time = config.as<i32>();
 }
 
+void parseBackoff(JobConfig* object, const YAML::Node& config)
+{
+    // by default the first restart waits 1 second and every following restart twice as long, up to a minute
+    object->backoff = JobConfig::Backoff{1, 2, 60, 0.1};
+
+    if (!config.IsDefined())
+        return;
+
+    if (!config.IsMap())
+        throw std::runtime_error("ERROR: backoff must be a map for job " + object->name);
+
+    if (config["base"].IsDefined())
+        object->backoff.base = config["base"].as<double>();
+    if (config["factor"].IsDefined())
+        object->backoff.factor = config["factor"].as<double>();
+    if (config["max"].IsDefined())
+        object->backoff.max = config["max"].as<double>();
+    if (config["jitter"].IsDefined())
+        object->backoff.jitter = config["jitter"].as<double>();
+
+    const JobConfig::Backoff& backoff = object->backoff;
+    if (backoff.base < 0 || backoff.factor < 1 || backoff.max < backoff.base || backoff.jitter < 0 || backoff.jitter > 1)
+        throw std::runtime_error("ERROR: Invalid backoff value for job " + object->name);
+}
+
+void parseBreaker(JobConfig* object, const YAML::Node& config)
+{
+    // disabled by default, so start_retries alone limits the restarts
+    object->breaker = JobConfig::Breaker{0, 60, 60};
+
+    if (!config.IsDefined())
+        return;
+
+    if (!config.IsMap())
+        throw std::runtime_error("ERROR: breaker must be a map for job " + object->name);
+
+    if (config["threshold"].IsDefined())
+        object->breaker.threshold = config["threshold"].as<i32>();
+    if (config["window"].IsDefined())
+        object->breaker.window = config["window"].as<i32>();
+    if (config["cooldown"].IsDefined())
+        object->breaker.cooldown = config["cooldown"].as<i32>();
+
+    const JobConfig::Breaker& breaker = object->breaker;
+    if (breaker.threshold < 0 || breaker.window <= 0 || breaker.cooldown < 0)
+        throw std::runtime_error("ERROR: Invalid breaker value for job " + object->name);
+}
+
+void parseRollingBatch(JobConfig* object, const YAML::Node& config)
+{
+    if (!config.IsDefined()) {
+        // by default a rolling restart replaces 10% of the processes at a time
+        object->rolling_batch = 10;
+        return;
+    }
+
+    std::string result = config.as<std::string>();
+
+    // accept both 25 and 25%
+    if (!result.empty() && result.back() == '%')
+        result.pop_back();
+    if (result.empty() || result.find_first_not_of("0123456789") != std::string::npos || std::stoi(result) < 1 || std::stoi(result) > 100)
+        throw std::runtime_error("ERROR: Invalid rollingbatch value for job " + object->name);
+
+    object->rolling_batch = std::stoi(result);
+}
+
+void parsePriority(JobConfig* object, const YAML::Node& config)
+{
+    if (!config.IsDefined()) {
+        // like supervisor, jobs with a lower priority are started first
+        object->priority = 999;
+        return;
+    }
+
+    object->priority = config.as<i32>();
+}
+
+void parseDependsOn(JobConfig* object, const YAML::Node& config)
+{
+    if (!config.IsDefined())
+        return;
+
+    if (config.IsScalar())
+        object->depends_on.push_back(config.as<std::string>());
+    else
+        object->depends_on = config.as<std::vector<std::string>>();
+
+    // sort the vector so that it can be properly compared
+    std::sort(object->depends_on.begin(), object->depends_on.end());
+    object->depends_on.erase(std::unique(object->depends_on.begin(), object->depends_on.end()), object->depends_on.end());
+}
+
 void parseStopSignal(JobConfig* object, const YAML::Node& config)
 {
     if (!config.IsDefined()) {
@@ -150,40 +303,87 @@ void parseStopTime(JobConfig* object, const YAML::Node& config)
 
 void parseSTDOUT(JobConfig* object, const YAML::Node& config)
 {
-
+    // If not present default is no redirection, the directory is checked every time the file is opened
     if (!config.IsDefined()) {
-        // If not present default is no redirection
         object->out = std::nullopt;
         return;
     }
-
-    std::filesystem::path path = config.as<std::string>();
-    std::filesystem::path dir  = path.parent_path();
-
-    if (!std::filesystem::exists(dir)) {
-        LOG_WARNING("Directory of Path: [" + path.string() + "] doesn't exists! Redirect to stdout");
-        object->out = std::nullopt;
-    } else {
-        object->out = config.as<std::string>();
-    }
+    object->out = config.as<std::string>();
 }
 
 void parseSTDERR(JobConfig* object, const YAML::Node& config)
 {
+    // If not present default is no redirection, the directory is checked every time the file is opened
     if (!config.IsDefined()) {
-        // If not present default is no redirection
         object->err = std::nullopt;
         return;
     }
-    std::filesystem::path path = config.as<std::string>();
-    std::filesystem::path dir  = path.parent_path();
+    object->err = config.as<std::string>();
+}
 
-    if (!std::filesystem::exists(dir)) {
-        LOG_WARNING("Directory of Path: [" + path.string() + "] doesn't exists! Redirect to stderr");
-        object->err = std::nullopt;
-    } else {
-        object->err = config.as<std::string>();
+/**
+ * @brief Parse an amount of bytes, with an optional KB, MB or GB suffix like supervisor.
+ */
+u64 parseBytes(JobConfig* object, const YAML::Node& config, const char* key)
+{
+    static const std::pair<const char*, u64> units[] = {{"KB", 1ULL << 10}, {"MB", 1ULL << 20}, {"GB", 1ULL << 30}};
+
+    std::string result = config.as<std::string>();
+    u64         unit   = 1;
+
+    for (const auto& [suffix, size] : units) {
+        if (result.ends_with(suffix)) {
+            result.resize(result.size() - 2);
+            unit = size;
+            break;
+        }
     }
+    if (result.empty() || result.find_first_not_of("0123456789") != std::string::npos)
+        throw std::runtime_error("ERROR: Invalid " + std::string(key) + " value for job " + object->name);
+
+    return std::stoull(result) * unit;
+}
+
+void parseSTDOUTMaxBytes(JobConfig* object, const YAML::Node& config)
+{
+    // by default the file is never rotated by size
+    object->out_rotation.max_bytes = config.IsDefined() ? parseBytes(object, config, "stdout_maxbytes") : 0;
+}
+
+void parseSTDERRMaxBytes(JobConfig* object, const YAML::Node& config)
+{
+    object->err_rotation.max_bytes = config.IsDefined() ? parseBytes(object, config, "stderr_maxbytes") : 0;
+}
+
+void parseSTDOUTBackups(JobConfig* object, const YAML::Node& config)
+{
+    // like supervisor, 10 rotated files are kept
+    object->out_rotation.backups = config.IsDefined() ? config.as<u32>() : 10;
+}
+
+void parseSTDERRBackups(JobConfig* object, const YAML::Node& config)
+{
+    object->err_rotation.backups = config.IsDefined() ? config.as<u32>() : 10;
+}
+
+void parseLogInterval(JobConfig* object, const YAML::Node& config)
+{
+    // the interval applies to both files, by default they are only rotated by size
+    i32 interval = config.IsDefined() ? config.as<i32>() : 0;
+
+    if (interval < 0)
+        throw std::runtime_error("ERROR: Invalid log_interval value for job " + object->name);
+
+    object->out_rotation.interval = interval;
+    object->err_rotation.interval = interval;
+}
+
+void parseLogCompress(JobConfig* object, const YAML::Node& config)
+{
+    bool compress = config.IsDefined() ? config.as<bool>() : false;
+
+    object->out_rotation.compress = compress;
+    object->err_rotation.compress = compress;
 }
 
 void parseENV(JobConfig* object, const YAML::Node& config)
@@ -203,52 +403,275 @@ void parseENV(JobConfig* object, const YAML::Node& config)
 JobConfig::JobConfig(const std::string& name, const YAML::Node& config)
     : name(name)
 {
-    static std::unordered_map<std::string, std::function<void(JobConfig*, const YAML::Node&)>> nodes = {{"cmd", parseCmd},
-                                                                                                        {"numprocs", parseNumberProcesses},
-                                                                                                        {"umask", parseUnMask},
-                                                                                                        {"workingdir", parseWorkingDir},
-                                                                                                        {"autostart", parseAutoStart},
-                                                                                                        {"autorestart", parseAutoRestart},
-                                                                                                        {"exitcodes", parseExitCodes},
-                                                                                                        {"startretries", parseStartRetries},
-                                                                                                        {"starttime", parseStartTime},
-                                                                                                        {"stopsignal", parseStopSignal},
-                                                                                                        {"stoptime", parseStopTime},
-                                                                                                        {"stdout", parseSTDOUT},
-                                                                                                        {"stderr", parseSTDERR},
-                                                                                                        {"env", parseENV}};
-
-
-  
+    using Parser = void (*)(JobConfig*, const YAML::Node&);
+
+    struct Option
+    {
+        const char* key;
+        Parser      parse;
+    };
+
+    static const Option options[] = {{"cmd", parseCmd},
+                                     {"numprocs", parseNumberProcesses},
+                                     {"umask", parseUnMask},
+                                     {"workingdir", parseWorkingDir},
+                                     {"autostart", parseAutoStart},
+                                     {"autorestart", parseAutoRestart},
+                                     {"exitcodes", parseExitCodes},
+                                     {"startretries", parseStartRetries},
+                                     {"starttime", parseStartTime},
+                                     {"notify", parseNotify},
+                                     {"backoff", parseBackoff},
+                                     {"breaker", parseBreaker},
+                                     {"rollingbatch", parseRollingBatch},
+                                     {"priority", parsePriority},
+                                     {"depends_on", parseDependsOn},
+                                     {"stopsignal", parseStopSignal},
+                                     {"stoptime", parseStopTime},
+                                     {"stdout", parseSTDOUT},
+                                     {"stderr", parseSTDERR},
+                                     {"stdout_maxbytes", parseSTDOUTMaxBytes},
+                                     {"stdout_backups", parseSTDOUTBackups},
+                                     {"stderr_maxbytes", parseSTDERRMaxBytes},
+                                     {"stderr_backups", parseSTDERRBackups},
+                                     {"log_interval", parseLogInterval},
+                                     {"log_compress", parseLogCompress},
+                                     {"env", parseENV}};
+    static const usize      count = std::size(options);
+    static const YAML::Node undefined(YAML::NodeType::Undefined);
+
+    // a single pass over the job node, every option is looked up in the table instead of looking up every option in the node
+    std::array<bool, count> parsed{};
     for (auto it = config.begin(); it != config.end(); ++it) {
+        std::string key    = it->first.as<std::string>();
+        auto        option = std::find_if(options, options + count, [&key](const Option& option) { return key == option.key; });
 
-        std::string option = it->first.as<std::string>();
-
-        if (nodes.find(option) == nodes.end()) {
-            LOG_WARNING("Unsupported Option [" + option + "] skipping....");
+        if (option == options + count) {
+            warn("Unsupported Option [" + key + "] skipping....");
             continue;
         }
+        if (parsed[option - options])
+            continue;
+        option->parse(this, it->second);
+        parsed[option - options] = true;
+    }
+
+    // the options that are missing fall back to their defaults
+    for (usize i = 0; i < count; i++) {
+        if (!parsed[i])
+            options[i].parse(this, undefined);
     }
 
-    for (auto& [option, func] : nodes) {
-        LOG_DEBUG("Parsing node: " + option);
-        func(this, config[option]);
+    // split the command now, so a broken command is reported when the config is loaded
+    splitCommand();
+    computeFingerprints();
+}
+
+void JobConfig::splitCommand()
+{
+    VariableLookup lookup = [this](std::string_view key) -> const char* {
+        std::string name(key);
+        auto        it = env.find(name);
+
+        return it != env.end() ? it->second.c_str() : std::getenv(name.c_str());
+    };
+
+    try {
+        argv = split_shell(cmd, lookup);
+    } catch (const std::exception& e) {
+        throw std::runtime_error("ERROR: Invalid cmd for job " + name + ": " + e.what());
+    }
+
+    if (argv.empty())
+        throw std::runtime_error("ERROR: cmd is empty for job " + name);
+}
+
+void JobConfig::computeFingerprints()
+{
+    Hasher spawn;
+
+    spawn.add(cmd);
+    spawn.add(working_dir);
+    spawn.add(umask);
+    spawn.add(out);
+    spawn.add(err);
+    spawn.add(notify);
+
+    // the order of an unordered_map is not stable, hash the variables sorted
+    std::vector<const EnvMap::value_type*> vars;
+    vars.reserve(env.size());
+    for (const auto& var : env)
+        vars.push_back(&var);
+    std::sort(vars.begin(), vars.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+    spawn.add(vars.size());
+    for (const auto* var : vars) {
+        spawn.add(var->first);
+        spawn.add(var->second);
+    }
+
+    spawn_fingerprint = spawn.get();
+
+    Hasher all;
+
+    all.add(spawn_fingerprint);
+    all.add(name);
+    all.add(numprocs);
+    all.add(autostart);
+    all.add(restart_policy);
+    all.add(exit_codes.size());
+    for (i32 code : exit_codes)
+        all.add(code);
+    all.add(start_retries);
+    all.add(start_time);
+    all.add(stop_time);
+    all.add(backoff.base);
+    all.add(backoff.factor);
+    all.add(backoff.max);
+    all.add(backoff.jitter);
+    all.add(breaker.threshold);
+    all.add(breaker.window);
+    all.add(breaker.cooldown);
+    all.add(rolling_batch);
+    all.add(priority);
+    all.add(depends_on.size());
+    for (const std::string& dependency : depends_on)
+        all.add(dependency);
+    all.add(stop_signal);
+    for (const Rotation& rotation : {out_rotation, err_rotation}) {
+        all.add(rotation.max_bytes);
+        all.add(rotation.backups);
+        all.add(rotation.interval);
+        all.add(rotation.compress);
     }
+
+    fingerprint = all.get();
+}
+
+void JobConfig::toSnapshot(proto::JobConfigSnapshot& message) const
+{
+    message.set_name(name);
+    message.set_cmd(cmd);
+    message.set_working_dir(working_dir);
+    message.set_numprocs(numprocs);
+    message.set_umask(umask);
+    message.set_autostart(autostart);
+    message.set_restart_policy(static_cast<i32>(restart_policy));
+    for (i32 code : exit_codes)
+        message.add_exit_codes(code);
+    message.set_start_retries(start_retries);
+    message.set_start_time(start_time);
+    message.set_stop_time(stop_time);
+    message.set_backoff_base(backoff.base);
+    message.set_backoff_factor(backoff.factor);
+    message.set_backoff_max(backoff.max);
+    message.set_backoff_jitter(backoff.jitter);
+    message.set_breaker_threshold(breaker.threshold);
+    message.set_breaker_window(breaker.window);
+    message.set_breaker_cooldown(breaker.cooldown);
+    message.set_rolling_batch(rolling_batch);
+    message.set_priority(priority);
+    message.set_notify(notify);
+    for (const std::string& dependency : depends_on)
+        message.add_depends_on(dependency);
+    message.set_stop_signal(static_cast<i32>(stop_signal));
+    if (out.has_value())
+        message.set_stdout_path(out.value());
+    if (err.has_value())
+        message.set_stderr_path(err.value());
+    message.set_stdout_maxbytes(out_rotation.max_bytes);
+    message.set_stdout_backups(out_rotation.backups);
+    message.set_stderr_maxbytes(err_rotation.max_bytes);
+    message.set_stderr_backups(err_rotation.backups);
+    message.set_log_interval(out_rotation.interval);
+    message.set_log_compress(out_rotation.compress);
+    for (const auto& [key, value] : env)
+        (*message.mutable_env())[key] = value;
+}
+
+JobConfig JobConfig::fromSnapshot(const proto::JobConfigSnapshot& message)
+{
+    JobConfig config;
+
+    config.name           = message.name();
+    config.cmd            = message.cmd();
+    config.working_dir    = message.working_dir();
+    config.numprocs       = message.numprocs();
+    config.umask          = message.umask();
+    config.autostart      = message.autostart();
+    config.restart_policy = static_cast<RestartPolicy>(message.restart_policy());
+    config.exit_codes.assign(message.exit_codes().begin(), message.exit_codes().end());
+    config.start_retries = message.start_retries();
+    config.start_time    = message.start_time();
+    config.stop_time     = message.stop_time();
+    config.backoff       = Backoff{message.backoff_base(), message.backoff_factor(), message.backoff_max(), message.backoff_jitter()};
+    config.breaker       = Breaker{message.breaker_threshold(), message.breaker_window(), message.breaker_cooldown()};
+    config.rolling_batch = message.rolling_batch();
+    config.priority      = message.priority();
+    config.notify        = message.notify();
+    config.depends_on.assign(message.depends_on().begin(), message.depends_on().end());
+    config.stop_signal   = static_cast<Signals>(message.stop_signal());
+    if (message.has_stdout_path())
+        config.out = message.stdout_path();
+    if (message.has_stderr_path())
+        config.err = message.stderr_path();
+    config.out_rotation = Rotation{message.stdout_maxbytes(), message.stdout_backups(), message.log_interval(), message.log_compress()};
+    config.err_rotation = Rotation{message.stderr_maxbytes(), message.stderr_backups(), message.log_interval(), message.log_compress()};
+    config.env = EnvMap(message.env().begin(), message.env().end());
+
+    config.splitCommand();
+    config.computeFingerprints();
+    return config;
 }
 
 std::unordered_map<std::string, JobConfig> JobConfig::getJobConfigs(const std::string& filename)
 {
-    std::unordered_map<std::string, JobConfig> jobConfigs;
-    YAML::Node                                 config = YAML::LoadFile(filename)["jobs"];
+    YAML::Node config = YAML::LoadFile(filename)["jobs"];
 
     if (!config.IsDefined()) {
         LOG_FATAL("ERROR: No 'jobs' node found in the configuration file.");
         throw std::runtime_error("ERROR: No 'jobs' node found in the configuration file.");
     }
 
-    for (auto it = config.begin(); it != config.end(); it++) {
-        std::string name = it->first.as<std::string>();
-        if (it->first.IsNull()) {
+    return getJobConfigs(config);
+}
+
+std::unordered_map<std::string, JobConfig> JobConfig::getJobConfigs(const YAML::Node& config)
+{
+    struct Entry
+    {
+        YAML::Node                 key;
+        YAML::Node                 node;
+        std::optional<JobConfig>   config;
+        std::vector<std::string>   warnings;
+        std::optional<std::string> error;
+    };
+
+    std::vector<Entry> entries;
+    for (auto it = config.begin(); it != config.end(); it++)
+        entries.push_back(Entry{it->first, it->second, std::nullopt, {}, std::nullopt});
+
+    // the jobs are independent, construct and validate them in parallel
+    parallelFor(entries.size(), [&entries](usize i) {
+        Entry& entry = entries[i];
+
+        if (entry.key.IsNull())
+            return;
+
+        t_warnings = &entry.warnings;
+        try {
+            entry.config.emplace(JobConfig(entry.key.as<std::string>(), entry.node));
+        } catch (const std::exception& e) {
+            entry.error = e.what();
+        }
+        t_warnings = nullptr;
+    });
+
+    // collect the results in the order of the file, so the map and the log are the same as when parsing one by one
+    std::unordered_map<std::string, JobConfig> jobConfigs;
+
+    for (Entry& entry : entries) {
+        std::string name = entry.key.as<std::string>();
+        if (entry.key.IsNull()) {
             LOG_ERROR("ERROR: Invalid job name: [" + name + "] Skipping...");
             continue;
         }
@@ -257,17 +680,19 @@ std::unordered_map<std::string, JobConfig> JobConfig::getJobConfigs(const std::s
             continue;
         }
 
-        try {
-            // Create a JobConfig object and add it to the map
-            jobConfigs.emplace(name, JobConfig(name, config[name]));
-        } catch (const std::exception& e) {
-            LOG_ERROR(("ERROR: Failed to parse job '" + name + "': " + e.what() + " Skipping...").c_str());
+        for (const std::string& warning : entry.warnings)
+            LOG_WARNING(warning);
+
+        if (entry.error.has_value()) {
+            LOG_ERROR(("ERROR: Failed to parse job '" + name + "': " + entry.error.value() + " Skipping...").c_str());
             continue;
         }
+        // Create a JobConfig object and add it to the map
+        jobConfigs.emplace(name, std::move(entry.config.value()));
     }
 
     // Return the map of job configurations
     // {job name, job config object}
     return jobConfigs;
 }
-} // namespace taskmasterd
\ No newline at end of file
+} // namespace taskmasterd
@@ -5,9 +5,15 @@
 #include "taskmasterd/include/core/EventManager.hpp"
 #include "taskmasterd/include/jobs/Job.hpp"
 #include "taskmasterd/include/jobs/JobConfig.hpp"
+#include "taskmasterd/include/jobs/Journal.hpp"
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <deque>
 #include <exception>
+#include <iomanip>
 #include <iostream>
+#include <optional>
 #include <stdexcept>
 #include <tuple>
 #include <utility>
@@ -15,13 +21,24 @@ namespace taskmasterd
 {
 
 JobManager::JobManager(const std::string& config_path)
-    : _config_path(config_path)
+    : _loader(config_path, ConfigLoader::getSnapshotPath())
 {
-    _config = JobConfig::getJobConfigs(config_path);
+    _config = _loader.load();
 
     for (const auto& [name, config] : _config) {
         _jobs.emplace(std::piecewise_construct, std::forward_as_tuple(name), std::forward_as_tuple(config, *this));
     }
+    mapDependents();
+
+    if (ConfigWatcher::isEnabled()) {
+        _watcher = std::make_unique<ConfigWatcher>([this]() {
+            LOG_INFO("Config files changed on disk, reloading");
+            proto::CommandResponse res = reload();
+            if (res.status() != proto::CommandStatus::OK)
+                LOG_ERROR(res.message());
+        });
+        _watcher->watch(_loader.getPatterns());
+    }
 }
 
 JobManager::~JobManager()
@@ -41,24 +58,30 @@ JobManager::~JobManager()
 
 void JobManager::start()
 {
+    std::vector<std::string> names;
+
     for (auto& [name, job] : _jobs) {
         if (job.getConfig().autostart) {
-            job.start();
+            names.push_back(name);
             LOG_INFO("Starting job: " + name);
         }
     }
+    startJobs(names);
 }
 
 proto::CommandResponse JobManager::start(const std::string& job_name)
 {
     proto::CommandResponse res;
     try {
-        Job& job = findJob(job_name);
+        findJob(job_name);
 
         try {
-            job.start();
+            startJobs({job_name});
             res.set_status(proto::CommandStatus::OK);
-            res.set_message("Successfully put job " + job_name + " in starting state.");
+            if (_waiting_start.find(job_name) != _waiting_start.end())
+                res.set_message("Successfully put job " + job_name + " in starting state, it waits for its dependencies.");
+            else
+                res.set_message("Successfully put job " + job_name + " in starting state.");
             return res;
         } catch (const std::exception& e) {
             res.set_status(proto::CommandStatus::ERROR);
@@ -76,10 +99,10 @@ proto::CommandResponse JobManager::stop(const std::string& job_name)
 {
     proto::CommandResponse res;
     try {
-        Job& job = findJob(job_name);
+        findJob(job_name);
 
         try {
-            job.stop();
+            stopJobs({job_name});
             res.set_status(proto::CommandStatus::OK);
             res.set_message("Successfully put job " + job_name + " in stopping state.");
             return res;
@@ -97,19 +120,33 @@ proto::CommandResponse JobManager::stop(const std::string& job_name)
 
 void JobManager::kill()
 {
-    for (auto& [name, job] : _jobs) {
-        job.stop();
-    }
+    std::vector<std::string> names;
+
+    for (auto& [name, job] : _jobs)
+        names.push_back(name);
+    stopJobs(names);
 }
 
-proto::CommandResponse JobManager::restart(const std::string& job_name)
+proto::CommandResponse JobManager::restart(const std::string& job_name, bool rolling)
 {
     proto::CommandResponse res;
     try {
         Job& job = findJob(job_name);
         try {
+            // a rolling restart only makes sense for a job with processes that are up
+            if (rolling && (job.getState() == Job::State::RUNNING || job.getState() == Job::State::STARTING)) {
+                if (job.isRolling()) {
+                    res.set_status(proto::CommandStatus::ERROR);
+                    res.set_message("A rolling restart of job " + job_name + " is already in progress.");
+                    return res;
+                }
+                job.rollingRestart();
+                res.set_status(proto::CommandStatus::OK);
+                res.set_message("Successfully started a rolling restart of job " + job_name + ".");
+                return res;
+            }
             job.stop();
-            job.start();
+            startJobs({job_name});
             res.set_status(proto::CommandStatus::OK);
             res.set_message("Successfully put job " + job_name + " in restarting state.");
             return res;
@@ -128,38 +165,96 @@ proto::CommandResponse JobManager::restart(const std::string& job_name)
 proto::CommandResponse JobManager::reload()
 {
     proto::CommandResponse res;
+    auto                   begin = std::chrono::steady_clock::now();
 
     try {
-        _config = JobConfig::getJobConfigs(_config_path);
+        _config = _loader.load();
     } catch (const std::exception &e) {
         res.set_status(proto::CommandStatus::ERROR);
         res.set_message(std::string("Failed to reload new config: fallback to old config! Issue: ") + e.what());
         return res;
     }
 
-    // loop through jobs that are changed or removed
-    for (auto& [name, job] : _jobs) {
+    // the include patterns may have changed
+    if (_watcher)
+        _watcher->watch(_loader.getPatterns());
 
-        // if job is not found or has changed we will have to stop the old job.
-        if (_config.find(name) == _config.end() || _config.at(name) != job.getConfig())
-            job.stop();
-    }
+    mapDependents();
 
-    // loop through the new config to add new jobs to the job manager
-    for (auto& [name, config] : _config) {
-        if (_jobs.find(name) == _jobs.end())
-            createJob(name);
-    }
+    ReloadPlan plan = planReload();
+
+    // jobs that are removed or need a restart are stopped, they are removed or replaced once they stopped
+    for (const std::string& name : plan.removed)
+        _jobs.at(name).stop();
+    for (const std::string& name : plan.restarted)
+        _jobs.at(name).stop();
+
+    // the other options, numprocs included, are applied without restarting the processes
+    for (const std::string& name : plan.updated)
+        _jobs.at(name).applyConfig(_config.at(name));
+
+    for (const std::string& name : plan.added)
+        createJob(name);
 
     // update the _jobs map
     update();
 
     start();
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - begin;
+    std::stringstream                         msg;
+
+    msg << "Reloaded the config file in " << std::fixed << std::setprecision(2) << elapsed.count() << " ms: " << plan.added.size() << " added, "
+        << plan.removed.size() << " removed, " << plan.restarted.size() << " restarted, " << plan.updated.size() << " updated in place, " << plan.unchanged
+        << " unchanged, parsed " << _loader.getParsedFiles() << " of " << _loader.getTotalFiles() << " files";
+
+    const std::pair<const char*, const std::vector<std::string>&> groups[] = {
+        {"added", plan.added}, {"removed", plan.removed}, {"restarted", plan.restarted}, {"updated", plan.updated}};
+    for (const auto& [label, names] : groups) {
+        if (names.empty())
+            continue;
+        msg << "\n" << label << ":";
+        for (const std::string& name : names)
+            msg << " " << name;
+    }
+    for (const std::string& warning : _loader.getWarnings())
+        msg << "\nwarning: " << warning;
+
+    LOG_INFO(msg.str());
     res.set_status(proto::CommandStatus::OK);
-    res.set_message("Successfully started a reload of the config file");
+    res.set_message(msg.str());
     return res;
 }
 
+JobManager::ReloadPlan JobManager::planReload() const
+{
+    ReloadPlan plan;
+
+    for (const auto& [name, job] : _jobs) {
+        auto it = _config.find(name);
+
+        if (it == _config.end())
+            plan.removed.push_back(name);
+        else if (it->second.requiresRestart(job.getConfig()))
+            plan.restarted.push_back(name);
+        else if (it->second != job.getConfig())
+            plan.updated.push_back(name);
+        else
+            plan.unchanged++;
+    }
+
+    for (const auto& [name, config] : _config) {
+        if (_jobs.find(name) == _jobs.end())
+            plan.added.push_back(name);
+    }
+
+    // the maps are unordered, sort the names for a stable response
+    for (std::vector<std::string>* names : {&plan.added, &plan.removed, &plan.restarted, &plan.updated})
+        std::sort(names->begin(), names->end());
+
+    return plan;
+}
+
 proto::CommandResponse JobManager::status()
 {
     proto::CommandResponse res;
@@ -193,29 +288,218 @@ proto::CommandResponse JobManager::status(const std::string& job_name)
     }
 }
 
+/**
+ * @brief Split a "name" or "name:index" target, the response is filled in when the index is not a number.
+ */
+static bool parseTarget(const std::string& target, std::string& job_name, std::optional<u32>& index, proto::CommandResponse& res)
+{
+    usize colon = target.rfind(':');
+
+    job_name = target.substr(0, colon);
+    try {
+        if (colon != std::string::npos) {
+            usize parsed = 0;
+
+            index = std::stoul(target.substr(colon + 1), &parsed);
+            if (parsed != target.size() - colon - 1)
+                throw std::invalid_argument("trailing characters");
+        }
+    } catch (const std::exception& e) {
+        res.set_status(proto::CommandStatus::ARGUMENT_ERROR);
+        res.set_message("Invalid argument: '" + target + "' is not a valid process index");
+        return false;
+    }
+    return true;
+}
+
+proto::CommandResponse JobManager::tail(const std::string& target, bool from_stderr, usize bytes, OutputFollower* follower)
+{
+    proto::CommandResponse res;
+    std::string            job_name;
+    std::optional<u32>     index;
+
+    if (!parseTarget(target, job_name, index, res))
+        return res;
+
+    auto it = _jobs.find(job_name);
+    if (it == _jobs.end()) {
+        res.set_status(proto::CommandStatus::ARGUMENT_ERROR);
+        res.set_message("Invalid argument: '" + job_name + "' cannot find job");
+        return res;
+    }
+
+    const Job& job = it->second;
+    if (index.has_value() && index.value() >= job.getProcessCount()) {
+        res.set_status(proto::CommandStatus::ARGUMENT_ERROR);
+        res.set_message("Invalid argument: '" + job_name + "' has " + std::to_string(job.getProcessCount()) + " processes");
+        return res;
+    }
+
+    u32         first = index.value_or(0);
+    u32         last  = index.has_value() ? index.value() + 1 : job.getProcessCount();
+    std::string output;
+
+    for (u32 i = first; i < last; i++) {
+        Process&      proc   = *job.getProcess(i);
+        OutputStream& stream = from_stderr ? proc.getStderr() : proc.getStdout();
+
+        if (last - first > 1)
+            output += (i != first ? "\n==> " : "==> ") + proc.getName() + " <==\n";
+        output += stream.getBuffer().tail(bytes);
+        if (follower != nullptr)
+            follower->follow(proc.getName(), stream);
+    }
+
+    res.set_status(proto::CommandStatus::OK);
+    res.set_output(output);
+    return res;
+}
+
+proto::CommandResponse JobManager::logs(const std::string& target, std::optional<u64> since)
+{
+    proto::CommandResponse res;
+    std::string            job_name;
+    std::optional<u32>     index;
+
+    if (!Journal::isEnabled()) {
+        res.set_status(proto::CommandStatus::ERROR);
+        res.set_message("The journal is disabled, set TASKMASTERD_JOURNAL to a directory to enable it");
+        return res;
+    }
+    if (!parseTarget(target, job_name, index, res))
+        return res;
+
+    struct Chunk
+    {
+        std::string source;
+        std::string data;
+    };
+
+    // the journal also has the output of jobs that were removed since
+    std::deque<Chunk> chunks;
+    usize             size     = 0;
+    bool              dropped  = false;
+    bool              complete = true;
+    i64               now      = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+    // consecutive output of a process is merged into chunks of a limited size, so the oldest can be dropped
+    auto append = [&](std::deque<Chunk>& target, const Journal::Record& record) {
+        if (record.job != job_name || (index.has_value() && record.index != index.value()))
+            return;
+
+        std::string source = job_name + "_" + std::to_string(record.index) + (record.stream == Journal::Stream::STDOUT ? " stdout" : " stderr");
+        if (!target.empty() && target.back().source == source && target.back().data.size() < LOGS_CHUNK_SIZE)
+            target.back().data.append(record.data);
+        else
+            target.push_back(Chunk{source, std::string(record.data)});
+        size += record.data.size();
+    };
+
+    if (since.has_value()) {
+        // a duration longer than the epoch asks for all output, comparing in seconds keeps the product from overflowing
+        i64 from = since.value() < static_cast<u64>(now / 1000000000) ? now - static_cast<i64>(since.value()) * 1000000000 : 0;
+
+        // the index seeks to the cutoff, the output from there on is read forward
+        Journal::getInstance().read(from, [&](const Journal::Record& record) {
+            append(chunks, record);
+            while (!chunks.empty() && size - chunks.front().data.size() >= MAX_LOGS_BYTES) {
+                size -= chunks.front().data.size();
+                chunks.pop_front();
+                dropped = true;
+            }
+        });
+    } else {
+        // without a cutoff the journal is walked back from the newest output until there is enough
+        complete = Journal::getInstance().readNewest(MAX_LOGS_SCAN, [&](const std::vector<Journal::Record>& records) {
+            std::deque<Chunk> block;
+
+            for (const Journal::Record& record : records)
+                append(block, record);
+            chunks.insert(chunks.begin(), std::make_move_iterator(block.begin()), std::make_move_iterator(block.end()));
+
+            dropped = size >= MAX_LOGS_BYTES;
+            return !dropped;
+        });
+
+        while (!chunks.empty() && size - chunks.front().data.size() >= MAX_LOGS_BYTES) {
+            size -= chunks.front().data.size();
+            chunks.pop_front();
+        }
+    }
+
+    if (chunks.empty()) {
+        res.set_status(proto::CommandStatus::OK);
+        res.set_message("No output of '" + target + "' in the " +
+                        (complete ? std::string("journal") : "newest " + std::to_string(MAX_LOGS_SCAN / (1024 * 1024)) + " MiB of the journal"));
+        return res;
+    }
+
+    // every change of process or stream gets a header, like tail does with several files
+    bool               mixed = std::any_of(chunks.begin(), chunks.end(), [&chunks](const Chunk& chunk) { return chunk.source != chunks.front().source; });
+    const std::string* last  = nullptr;
+    std::string        output;
+
+    if (dropped)
+        res.set_message("[... older output is not shown ...]");
+    else if (!complete)
+        res.set_message("[... only the newest " + std::to_string(MAX_LOGS_SCAN / (1024 * 1024)) + " MiB of the journal was searched ...]");
+    for (const Chunk& chunk : chunks) {
+        if (mixed && (last == nullptr || *last != chunk.source))
+            output += (output.empty() ? "==> " : "\n==> ") + chunk.source + " <==\n";
+        output += chunk.data;
+        last = &chunk.source;
+    }
+
+    res.set_status(proto::CommandStatus::OK);
+    res.set_output(output);
+    return res;
+}
+
 void JobManager::update()
 {
+    bool erased = false;
+
     for (auto it = _jobs.begin(); it != _jobs.end();) {
         const std::string name = it->first;
         Job&              job  = it->second;
 
         if (job.removed()) {
-            it = _jobs.erase(it);
+            _waiting_start.erase(name);
+            _waiting_stop.erase(name);
+            it     = _jobs.erase(it);
+            erased = true;
             continue;
         }
         if (job.replaced()) {
-            it = _jobs.erase(it);
+            it     = _jobs.erase(it);
+            erased = true;
             createJob(name);
+            if (_config.at(name).autostart)
+                startJobs({name});
             continue;
         }
+        if (job.hasSurplus())
+            job.trimProcesses();
         it++;
     }
+
+    // the new jobs already picked up their plans, drop the plans of the jobs that are gone
+    if (erased)
+        ExecPlan::prune();
 }
 
 void JobManager::onStop(const std::string job_name)
 {
     Job& job = _jobs.at(job_name);
 
+    // the dependencies that waited for this job can stop now
+    for (const std::string& dependency : job.getConfig().depends_on) {
+        if (_waiting_stop.find(dependency) == _waiting_stop.end() || !dependentsStopped(dependency))
+            continue;
+        _waiting_stop.erase(dependency);
+        _jobs.at(dependency).stop();
+    }
+
     // if the job is not in the config anymore we should schedule it to be removed
     if (_config.find(job_name) == _config.end())
         return job.remove();
@@ -243,8 +527,140 @@ void JobManager::createJob(const std::string& job_name)
     if (!map.second)
         throw std::runtime_error("new Job :" + job_name + " Couldn't be created");
 
-    if (_config.at(job_name).autostart)
-        map.first->second.start();
+}
+
+void JobManager::onRunning(const std::string& job_name)
+{
+    auto it = _dependents.find(job_name);
+
+    if (it == _dependents.end())
+        return;
+
+    // the dependents that waited for this job can start now, together with the others of their level
+    for (const std::string& dependent : it->second) {
+        if (_waiting_start.find(dependent) == _waiting_start.end() || !dependenciesRunning(dependent))
+            continue;
+        _waiting_start.erase(dependent);
+        LOG_INFO("Dependencies of job " + dependent + " are running, starting it");
+        _jobs.at(dependent).start();
+    }
+}
+
+void JobManager::startJobs(const std::vector<std::string>& names)
+{
+    std::vector<std::string>        pending(names);
+    std::unordered_set<std::string> seen(names.begin(), names.end());
+    std::vector<std::string>        ready;
+
+    // walk down the dependencies that are not running yet
+    while (!pending.empty()) {
+        std::string name = std::move(pending.back());
+        pending.pop_back();
+
+        auto it = _jobs.find(name);
+        if (it == _jobs.end())
+            continue;
+
+        // a job that waits to be replaced by its new config is started by update()
+        auto config = _config.find(name);
+        if (config == _config.end() || config->second.requiresRestart(it->second.getConfig()))
+            continue;
+
+        _waiting_stop.erase(name);
+        if (dependenciesRunning(name)) {
+            ready.push_back(name);
+            continue;
+        }
+        if (_waiting_start.insert(name).second)
+            LOG_INFO("Job " + name + " waits for its dependencies");
+
+        for (const std::string& dependency : it->second.getConfig().depends_on) {
+            auto found = _jobs.find(dependency);
+            if (found != _jobs.end() && found->second.getState() != Job::State::RUNNING && seen.insert(dependency).second)
+                pending.push_back(dependency);
+        }
+    }
+
+    for (const std::string& name : ready) {
+        _waiting_start.erase(name);
+        _jobs.at(name).start();
+    }
+}
+
+void JobManager::stopJobs(const std::vector<std::string>& names)
+{
+    std::vector<std::string>        pending(names);
+    std::unordered_set<std::string> seen(names.begin(), names.end());
+    std::vector<std::string>        ready;
+
+    // walk up the jobs that depend on the stopped jobs
+    while (!pending.empty()) {
+        std::string name = std::move(pending.back());
+        pending.pop_back();
+
+        if (_jobs.find(name) == _jobs.end())
+            continue;
+
+        _waiting_start.erase(name);
+        auto it = _dependents.find(name);
+        if (it != _dependents.end()) {
+            for (const std::string& dependent : it->second) {
+                if (seen.insert(dependent).second)
+                    pending.push_back(dependent);
+            }
+        }
+    }
+
+    // every job of the walk was seen, the jobs that still have dependents up wait for them
+    for (const std::string& name : seen) {
+        if (_jobs.find(name) == _jobs.end())
+            continue;
+        if (dependentsStopped(name))
+            ready.push_back(name);
+        else
+            _waiting_stop.insert(name);
+    }
+
+    for (const std::string& name : ready)
+        _jobs.at(name).stop();
+}
+
+bool JobManager::dependenciesRunning(const std::string& job_name) const
+{
+    for (const std::string& dependency : _jobs.at(job_name).getConfig().depends_on) {
+        auto it = _jobs.find(dependency);
+        if (it == _jobs.end() || it->second.getState() != Job::State::RUNNING)
+            return false;
+    }
+    return true;
+}
+
+bool JobManager::dependentsStopped(const std::string& job_name) const
+{
+    auto it = _dependents.find(job_name);
+
+    if (it == _dependents.end())
+        return true;
+
+    for (const std::string& dependent : it->second) {
+        auto found = _jobs.find(dependent);
+        if (found == _jobs.end())
+            continue;
+
+        Job::State state = found->second.getState();
+        if (state != Job::State::EMPTY && state != Job::State::STOPPED && state != Job::State::REPLACE && state != Job::State::REMOVE)
+            return false;
+    }
+    return true;
+}
+
+void JobManager::mapDependents()
+{
+    _dependents.clear();
+    for (const auto& [name, config] : _config) {
+        for (const std::string& dependency : config.depends_on)
+            _dependents[dependency].push_back(name);
+    }
 }
 
 } // namespace taskmasterd
\ No newline at end of file
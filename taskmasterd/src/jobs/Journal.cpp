@@ -0,0 +1,356 @@
+#include <taskmasterd/include/jobs/Journal.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <filesystem>
+#include <stdexcept>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <logger/include/Logger.hpp>
+
+namespace taskmasterd
+{
+namespace
+{
+// "TMJRNL01" in a little endian file
+constexpr u64 MAGIC = 0x31304c4e524a4d54;
+
+// the size of a single read while scanning a segment, a record is at most about READ_SIZE / 2
+constexpr usize READ_SIZE = 1024 * 1024;
+
+struct SegmentHeader
+{
+    u64 magic;
+    i64 realtime;  // the wall clock when the segment was created, in nanoseconds
+    i64 monotonic; // the monotonic clock at the same moment, the clock of the timestamps of the records
+};
+
+struct RecordHeader
+{
+    i64 timestamp;
+    u32 size; // the amount of output after the job name
+    u32 index;
+    u16 job_length;
+    u8  stream;
+    u8  reserved[5];
+};
+
+struct IndexEntry
+{
+    i64 timestamp;
+    u64 offset;
+};
+
+static_assert(sizeof(SegmentHeader) == 24 && sizeof(RecordHeader) == 24 && sizeof(IndexEntry) == 16);
+
+i64 now(clockid_t clock)
+{
+    struct timespec time;
+
+    clock_gettime(clock, &time);
+    return static_cast<i64>(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+bool readHeader(i32 fd, SegmentHeader& header)
+{
+    return pread(fd, &header, sizeof(header), 0) == sizeof(header) && header.magic == MAGIC;
+}
+
+std::vector<IndexEntry> readIndex(const std::string& path)
+{
+    ipc::FileDescriptor     index(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    std::vector<IndexEntry> entries;
+    struct stat             info;
+
+    if (index.getFd() == -1 || fstat(index.getFd(), &info) == -1)
+        return entries;
+
+    entries.resize(info.st_size / sizeof(IndexEntry));
+
+    isize size = pread(index.getFd(), entries.data(), entries.size() * sizeof(IndexEntry), 0);
+    entries.resize(std::max<isize>(size, 0) / sizeof(IndexEntry));
+    return entries;
+}
+} // namespace
+
+Journal::Journal()
+    : _directory(std::getenv("TASKMASTERD_JOURNAL"))
+    , _size(0)
+    , _indexed(0)
+{
+    std::error_code error;
+
+    std::filesystem::create_directories(_directory, error);
+    if (error)
+        throw std::runtime_error("Failed to create the journal directory " + _directory + ": " + error.message());
+
+    // the segments of previous runs are kept, the numbers continue after the last one
+    for (const auto& entry : std::filesystem::directory_iterator(_directory, error)) {
+        const std::filesystem::path& path = entry.path();
+
+        if (path.extension() != ".journal")
+            continue;
+
+        std::string stem = path.stem().string();
+        if (stem.empty() || stem.find_first_not_of("0123456789") != std::string::npos)
+            continue;
+        _segments.push_back(std::strtoul(stem.c_str(), nullptr, 10));
+    }
+    if (error)
+        throw std::runtime_error("Failed to list the journal directory " + _directory + ": " + error.message());
+    std::sort(_segments.begin(), _segments.end());
+
+    roll();
+
+    LOG_INFO("Journal in " + _directory + ", segment " + std::to_string(_segments.back()));
+}
+
+bool Journal::isEnabled()
+{
+    const char* directory = std::getenv("TASKMASTERD_JOURNAL");
+
+    return directory != nullptr && *directory != '\0';
+}
+
+void Journal::append(const Source& source, const char* data, usize size)
+{
+    // a journal that failed is not written anymore
+    if (_segment.getFd() == -1)
+        return;
+
+    RecordHeader header = {};
+    header.timestamp    = now(CLOCK_MONOTONIC);
+    header.size         = size;
+    header.index        = source.index;
+    header.job_length   = std::min<usize>(source.job.size(), UINT16_MAX);
+    header.stream       = static_cast<u8>(source.stream);
+
+    usize length = sizeof(header) + header.job_length + size;
+
+    try {
+        if (_size + length > SEGMENT_SIZE && _size > sizeof(SegmentHeader))
+            roll();
+    } catch (const std::exception& e) {
+        LOG_ERROR(std::string(e.what()) + ", the journal is stopped");
+        _segment.close();
+        _index.close();
+        return;
+    }
+
+    // the index only points at a record every INDEX_INTERVAL bytes, a query scans at most that much too far
+    if (_size >= _indexed) {
+        IndexEntry entry = {header.timestamp, _size};
+
+        if (write(_index.getFd(), &entry, sizeof(entry)) == sizeof(entry))
+            _indexed = _size + INDEX_INTERVAL;
+    }
+
+    struct iovec parts[3] = {
+        {&header, sizeof(header)},
+        {const_cast<char*>(source.job.data()), header.job_length},
+        {const_cast<char*>(data), size},
+    };
+
+    // a record that is cut short is past the end of the segment, the readers stop before it
+    isize written = writev(_segment.getFd(), parts, 3);
+    if (written != static_cast<isize>(length)) {
+        LOG_ERROR("Failed to write to the journal, it is stopped: " + std::string(written == -1 ? strerror(errno) : "short write"));
+        _segment.close();
+        _index.close();
+        return;
+    }
+    _size += length;
+}
+
+void Journal::read(i64 since, const Visitor& visitor) const
+{
+    // the segments before the last one that started before 'since' ended before it started
+    usize first = 0;
+
+    for (usize i = _segments.size(); i-- > 0;) {
+        ipc::FileDescriptor segment(open(getPath(_segments[i], ".journal").c_str(), O_RDONLY | O_CLOEXEC));
+        SegmentHeader       header;
+
+        if (segment.getFd() != -1 && readHeader(segment.getFd(), header) && header.realtime <= since) {
+            first = i;
+            break;
+        }
+    }
+
+    for (usize i = first; i < _segments.size(); i++)
+        readSegment(_segments[i], since, visitor);
+}
+
+void Journal::readSegment(u32 sequence, i64 since, const Visitor& visitor) const
+{
+    ipc::FileDescriptor segment(open(getPath(sequence, ".journal").c_str(), O_RDONLY | O_CLOEXEC));
+    SegmentHeader       header;
+
+    // a segment that was removed in the meantime or is not a journal is skipped
+    if (segment.getFd() == -1 || !readHeader(segment.getFd(), header))
+        return;
+
+    // 'since' on the monotonic clock of the segment
+    i64 threshold = since - header.realtime + header.monotonic;
+    u64 offset    = seek(sequence, threshold);
+
+    std::vector<char> buffer(READ_SIZE);
+    usize             begin = 0;
+    usize             end   = 0;
+
+    while (true) {
+        // move the start of an incomplete record to the front and read the rest
+        std::copy(buffer.begin() + begin, buffer.begin() + end, buffer.begin());
+        end -= begin;
+        begin = 0;
+
+        isize size = pread(segment.getFd(), buffer.data() + end, buffer.size() - end, offset);
+        if (size <= 0)
+            return;
+        offset += size;
+        end += size;
+
+        while (end - begin >= sizeof(RecordHeader)) {
+            RecordHeader record;
+
+            memcpy(&record, buffer.data() + begin, sizeof(record));
+
+            usize length = sizeof(record) + record.job_length + record.size;
+            if (length > buffer.size())
+                return;
+            if (end - begin < length)
+                break;
+
+            if (record.timestamp >= threshold) {
+                const char* job = buffer.data() + begin + sizeof(record);
+
+                visitor(Record{std::string_view(job, record.job_length), record.index, static_cast<Stream>(record.stream),
+                               header.realtime + (record.timestamp - header.monotonic), std::string_view(job + record.job_length, record.size)});
+            }
+            begin += length;
+        }
+    }
+}
+
+bool Journal::readNewest(u64 limit, const BlockVisitor& visitor) const
+{
+    u64                 scanned = 0;
+    std::vector<char>   buffer;
+    std::vector<Record> records;
+
+    for (usize i = _segments.size(); i-- > 0;) {
+        ipc::FileDescriptor segment(open(getPath(_segments[i], ".journal").c_str(), O_RDONLY | O_CLOEXEC));
+        SegmentHeader       header;
+        struct stat         info;
+
+        // a segment that was removed in the meantime or is not a journal is skipped
+        if (segment.getFd() == -1 || !readHeader(segment.getFd(), header) || fstat(segment.getFd(), &info) == -1)
+            continue;
+
+        std::vector<IndexEntry> entries = readIndex(getPath(_segments[i], ".index"));
+
+        // the first record is always indexed, without it the segment is read as a single block
+        if (entries.empty() || entries.front().offset != sizeof(SegmentHeader))
+            entries.insert(entries.begin(), IndexEntry{header.monotonic, sizeof(SegmentHeader)});
+
+        for (usize block = entries.size(); block-- > 0;) {
+            u64 begin = entries[block].offset;
+            u64 end   = block + 1 < entries.size() ? entries[block + 1].offset : static_cast<u64>(info.st_size);
+
+            if (begin >= end)
+                continue;
+
+            buffer.resize(end - begin);
+            isize size = pread(segment.getFd(), buffer.data(), buffer.size(), begin);
+            if (size <= 0)
+                break;
+            scanned += size;
+
+            // a block starts at a record, a record that is cut short is the end of the segment
+            records.clear();
+            for (usize offset = 0; static_cast<usize>(size) - offset >= sizeof(RecordHeader);) {
+                RecordHeader record;
+
+                memcpy(&record, buffer.data() + offset, sizeof(record));
+
+                usize length = sizeof(record) + record.job_length + record.size;
+                if (static_cast<usize>(size) - offset < length)
+                    break;
+
+                const char* job = buffer.data() + offset + sizeof(record);
+
+                records.push_back(Record{std::string_view(job, record.job_length), record.index, static_cast<Stream>(record.stream),
+                                         header.realtime + (record.timestamp - header.monotonic), std::string_view(job + record.job_length, record.size)});
+                offset += length;
+            }
+
+            if (!records.empty() && !visitor(records))
+                return true;
+            if (scanned >= limit)
+                return false;
+        }
+    }
+    return true;
+}
+
+u64 Journal::seek(u32 sequence, i64 timestamp) const
+{
+    std::vector<IndexEntry> entries = readIndex(getPath(sequence, ".index"));
+
+    // the timestamps within a segment only go up, the record before the first later one is where to start
+    auto later = std::partition_point(entries.begin(), entries.end(), [timestamp](const IndexEntry& entry) { return entry.timestamp < timestamp; });
+    if (later == entries.begin())
+        return sizeof(SegmentHeader);
+    return std::prev(later)->offset;
+}
+
+void Journal::roll()
+{
+    u32         sequence = _segments.empty() ? 1 : _segments.back() + 1;
+    std::string path     = getPath(sequence, ".journal");
+
+    _segment = ipc::FileDescriptor(open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644));
+    if (_segment.getFd() == -1)
+        throw std::runtime_error("Failed to create the journal segment " + path + ": " + strerror(errno));
+
+    _index = ipc::FileDescriptor(open(getPath(sequence, ".index").c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644));
+    if (_index.getFd() == -1)
+        throw std::runtime_error("Failed to create the index of journal segment " + path + ": " + strerror(errno));
+
+    SegmentHeader header = {MAGIC, now(CLOCK_REALTIME), now(CLOCK_MONOTONIC)};
+    if (write(_segment.getFd(), &header, sizeof(header)) != sizeof(header))
+        throw std::runtime_error("Failed to write the journal segment " + path + ": " + strerror(errno));
+
+    _segments.push_back(sequence);
+    _size    = sizeof(header);
+    _indexed = _size;
+
+    while (_segments.size() > MAX_SEGMENTS) {
+        unlink(getPath(_segments.front(), ".journal").c_str());
+        unlink(getPath(_segments.front(), ".index").c_str());
+        _segments.erase(_segments.begin());
+    }
+}
+
+std::string Journal::getPath(u32 sequence, const char* extension) const
+{
+    char name[16];
+
+    snprintf(name, sizeof(name), "%08u", sequence);
+    return _directory + "/" + name + extension;
+}
+
+Journal& Journal::getInstance()
+{
+    static Journal instance;
+
+    return instance;
+}
+} // namespace taskmasterd
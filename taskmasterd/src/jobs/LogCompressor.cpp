@@ -0,0 +1,151 @@
+#include <taskmasterd/include/jobs/LogCompressor.hpp>
+
+#include <fcntl.h>
+#include <stdexcept>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <logger/include/Logger.hpp>
+#include <taskmasterd/include/core/EventManager.hpp>
+
+namespace taskmasterd
+{
+namespace
+{
+// the size of a single read from the rotated file
+constexpr usize CHUNK_SIZE = 128 * 1024;
+
+// the worker gives way to the supervision of processes
+constexpr i32 WORKER_NICE = 10;
+} // namespace
+
+LogCompressor::LogCompressor()
+    : ipc::FileDescriptor(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+{
+    if (_fd == -1)
+        throw std::runtime_error("Failed to create the eventfd of the log compressor: " + std::string(strerror(errno)));
+
+    EventManager::getInstance().registerEvent(*this, std::bind(&LogCompressor::onDone, this), nullptr);
+
+    _thread = std::jthread(std::bind_front(&LogCompressor::run, this));
+}
+
+LogCompressor::~LogCompressor()
+{
+    // the files that are still queued stay uncompressed
+    _thread.request_stop();
+    if (_thread.joinable())
+        _thread.join();
+
+    EventManager::getInstance().unregisterEvent(*this);
+}
+
+void LogCompressor::compress(const std::string& path)
+{
+    _pending.insert(path);
+    {
+        std::lock_guard lock(_mutex);
+
+        _queue.push_back(path);
+    }
+    _wake.notify_one();
+}
+
+void LogCompressor::run(std::stop_token token)
+{
+    setpriority(PRIO_PROCESS, gettid(), WORKER_NICE);
+
+    while (true) {
+        std::string path;
+        {
+            std::unique_lock lock(_mutex);
+
+            if (!_wake.wait(lock, token, [this]() { return !_queue.empty(); }))
+                return;
+            path = std::move(_queue.front());
+            _queue.pop_front();
+        }
+
+        std::optional<std::string> error = compressFile(path);
+        {
+            std::lock_guard lock(_mutex);
+
+            _results.push_back(Result{path, error});
+        }
+
+        u64 done = 1;
+        if (::write(_fd, &done, sizeof(done)) == -1)
+            continue;
+    }
+}
+
+std::optional<std::string> LogCompressor::compressFile(const std::string& path)
+{
+    std::string         target = path + ".gz";
+    std::string         temp   = target + ".tmp";
+    ipc::FileDescriptor source(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+
+    if (source.getFd() == -1)
+        return "Failed to open " + path + ": " + strerror(errno);
+
+    // the compressed file only gets its name once it is complete
+    gzFile output = gzopen(temp.c_str(), "wbe");
+    if (output == nullptr)
+        return "Failed to create " + temp + ": " + strerror(errno);
+
+    std::unique_ptr<char[]> buffer(new char[CHUNK_SIZE]);
+    isize                   size;
+    while ((size = read(source.getFd(), buffer.get(), CHUNK_SIZE)) > 0) {
+        if (gzwrite(output, buffer.get(), size) != size) {
+            gzclose(output);
+            unlink(temp.c_str());
+            return "Failed to write " + temp;
+        }
+    }
+
+    if (gzclose(output) != Z_OK || size == -1) {
+        unlink(temp.c_str());
+        return "Failed to compress " + path;
+    }
+    if (rename(temp.c_str(), target.c_str()) == -1) {
+        unlink(temp.c_str());
+        return "Failed to rename " + temp + ": " + strerror(errno);
+    }
+
+    unlink(path.c_str());
+    return std::nullopt;
+}
+
+void LogCompressor::onDone()
+{
+    u64 count;
+    if (::read(_fd, &count, sizeof(count)) == -1)
+        return;
+
+    std::vector<Result> results;
+    {
+        std::lock_guard lock(_mutex);
+
+        results.swap(_results);
+    }
+
+    for (const Result& result : results) {
+        _pending.erase(result.path);
+        if (result.error.has_value()) {
+            LOG_ERROR("Failed to compress a log file, it is kept as is: " + result.error.value());
+        } else {
+            LOG_DEBUG("Compressed " + result.path);
+        }
+    }
+}
+
+LogCompressor& LogCompressor::getInstance()
+{
+    static LogCompressor instance;
+
+    return instance;
+}
+} // namespace taskmasterd
@@ -0,0 +1,173 @@
+#include <taskmasterd/include/jobs/LogFile.hpp>
+
+#include <fcntl.h>
+#include <stdexcept>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <logger/include/Logger.hpp>
+#include <taskmasterd/include/jobs/LogCompressor.hpp>
+
+namespace taskmasterd
+{
+std::unordered_map<std::string, std::weak_ptr<LogFile>> LogFile::_files;
+
+static i32 openFile(const std::string& path)
+{
+    i32 fd = open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+
+    if (fd == -1)
+        throw std::runtime_error("Failed to open " + path + ": " + strerror(errno));
+    return fd;
+}
+
+LogFile::LogFile(const std::string& path, const JobConfig::Rotation& rotation)
+    : ipc::FileDescriptor(openFile(path))
+    , _path(path)
+    , _rotation{}
+    , _size(0)
+    , _postponed(false)
+{
+    struct stat info;
+
+    // a restart of the daemon keeps appending to the file
+    if (fstat(_fd, &info) == 0)
+        _size = info.st_size;
+
+    setRotation(rotation);
+}
+
+LogFile::~LogFile()
+{
+    auto it = _files.find(_path);
+
+    if (it != _files.end() && it->second.expired())
+        _files.erase(it);
+}
+
+std::shared_ptr<LogFile> LogFile::get(const std::string& path, const JobConfig::Rotation& rotation)
+{
+    std::shared_ptr<LogFile> file = _files[path].lock();
+
+    if (file != nullptr) {
+        file->setRotation(rotation);
+        return file;
+    }
+
+    file.reset(new LogFile(path, rotation));
+    _files[path] = file;
+    return file;
+}
+
+void LogFile::setRotation(const JobConfig::Rotation& rotation)
+{
+    bool restart = rotation.interval != _rotation.interval;
+
+    _rotation = rotation;
+    if (!restart)
+        return;
+
+    _timer.reset();
+    if (_rotation.interval == 0)
+        return;
+
+    _timer.reset(new Timer(_rotation.interval, [this]() {
+        rotate();
+        _timer->start();
+    }));
+    _timer->start();
+}
+
+bool LogFile::write(const char* data, usize size)
+{
+    while (size > 0) {
+        isize written = pwrite(_fd, data, size, _size);
+
+        if (written == -1 && errno == EINTR)
+            continue;
+        if (written == -1)
+            return false;
+
+        data += written;
+        size -= written;
+        onWritten(written);
+    }
+    return true;
+}
+
+isize LogFile::splice(i32 pipe, usize size)
+{
+    loff_t offset = _size;
+    isize  moved  = ::splice(pipe, nullptr, _fd, &offset, size, SPLICE_F_MOVE);
+
+    if (moved > 0)
+        onWritten(moved);
+    return moved;
+}
+
+void LogFile::onWritten(usize size)
+{
+    _size += size;
+
+    if ((_rotation.max_bytes != 0 && _size >= _rotation.max_bytes) || _postponed)
+        rotate();
+}
+
+void LogFile::rotate()
+{
+    if (_size == 0)
+        return;
+
+    // without backups the file starts over
+    if (_rotation.backups == 0) {
+        if (ftruncate(_fd, 0) == -1) {
+            LOG_ERROR("Failed to truncate " + _path + ": " + strerror(errno));
+            return;
+        }
+        _size = 0;
+        return;
+    }
+
+    // the first backup is renamed below, it cannot be while the worker still reads it
+    LogCompressor& compressor = LogCompressor::getInstance();
+    _postponed                = compressor.isCompressing(getBackup(1, false));
+    if (_postponed)
+        return;
+
+    // the oldest backup is dropped and the others move up, compressed or not
+    for (bool compressed : {false, true}) {
+        unlink(getBackup(_rotation.backups, compressed).c_str());
+        for (u32 i = _rotation.backups - 1; i >= 1; i--)
+            rename(getBackup(i, compressed).c_str(), getBackup(i + 1, compressed).c_str());
+    }
+
+    if (rename(_path.c_str(), getBackup(1, false).c_str()) == -1) {
+        LOG_ERROR("Failed to rotate " + _path + ": " + strerror(errno));
+        return;
+    }
+
+    try {
+        i32 fd = openFile(_path);
+
+        close();
+        _fd   = fd;
+        _size = 0;
+    } catch (const std::exception& e) {
+        // the renamed file is written until the file can be created again
+        LOG_ERROR(e.what());
+        return;
+    }
+
+    LOG_INFO("Rotated " + _path);
+
+    if (_rotation.compress)
+        compressor.compress(getBackup(1, false));
+}
+
+std::string LogFile::getBackup(u32 index, bool compressed) const
+{
+    return _path + "." + std::to_string(index) + (compressed ? ".gz" : "");
+}
+} // namespace taskmasterd
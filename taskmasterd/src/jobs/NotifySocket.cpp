@@ -0,0 +1,140 @@
+#include <taskmasterd/include/jobs/NotifySocket.hpp>
+
+#include <cstddef>
+#include <stdexcept>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <logger/include/Logger.hpp>
+#include <taskmasterd/include/core/EventManager.hpp>
+#include <taskmasterd/include/jobs/Process.hpp>
+
+namespace taskmasterd
+{
+namespace
+{
+// sd_notify may pass file descriptors along, they are not kept and closed right away
+constexpr usize MAX_FDS = 16;
+} // namespace
+
+NotifySocket::NotifySocket()
+    : ipc::FileDescriptor(socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0))
+    , _address("@taskmasterd/notify/" + std::to_string(getpid()))
+{
+    if (_fd == -1)
+        throw std::runtime_error("Failed to create the notify socket: " + std::string(strerror(errno)));
+
+    // let the kernel attach the pid of the sender to every message
+    i32 enable = 1;
+    if (setsockopt(_fd, SOL_SOCKET, SO_PASSCRED, &enable, sizeof(enable)) == -1)
+        throw std::runtime_error("Failed to enable the credentials of the notify socket: " + std::string(strerror(errno)));
+
+    // an abstract address starts with a null byte instead of the '@' and is gone with the daemon
+    struct sockaddr_un address = {};
+    address.sun_family         = AF_UNIX;
+    memcpy(address.sun_path + 1, _address.data() + 1, _address.size() - 1);
+
+    socklen_t length = offsetof(struct sockaddr_un, sun_path) + _address.size();
+    if (bind(_fd, reinterpret_cast<struct sockaddr*>(&address), length) == -1)
+        throw std::runtime_error("Failed to bind the notify socket " + _address + ": " + strerror(errno));
+
+    EventManager::getInstance().registerEvent(*this, std::bind(&NotifySocket::onMessage, this), nullptr);
+
+    LOG_DEBUG("Notify socket listening on " + _address);
+}
+
+NotifySocket::~NotifySocket()
+{
+    if (_fd != -1)
+        EventManager::getInstance().unregisterEvent(*this);
+}
+
+void NotifySocket::subscribe(pid_t pid, Process& proc)
+{
+    _processes[pid] = &proc;
+}
+
+void NotifySocket::unsubscribe(pid_t pid, const Process& proc)
+{
+    auto it = _processes.find(pid);
+
+    if (it != _processes.end() && it->second == &proc)
+        _processes.erase(it);
+}
+
+void NotifySocket::onMessage()
+{
+    char buffer[4096];
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(struct ucred)) + CMSG_SPACE(sizeof(i32) * MAX_FDS)];
+
+    while (true) {
+        struct iovec  vector  = {buffer, sizeof(buffer)};
+        struct msghdr message = {};
+
+        message.msg_iov        = &vector;
+        message.msg_iovlen     = 1;
+        message.msg_control    = control;
+        message.msg_controllen = sizeof(control);
+
+        isize size = recvmsg(_fd, &message, MSG_CMSG_CLOEXEC);
+        if (size == -1 && errno == EINTR)
+            continue;
+        if (size < 0)
+            break;
+
+        pid_t pid = 0;
+        for (struct cmsghdr* header = CMSG_FIRSTHDR(&message); header != nullptr; header = CMSG_NXTHDR(&message, header)) {
+            if (header->cmsg_level != SOL_SOCKET)
+                continue;
+
+            if (header->cmsg_type == SCM_CREDENTIALS) {
+                struct ucred credentials;
+
+                memcpy(&credentials, CMSG_DATA(header), sizeof(credentials));
+                pid = credentials.pid;
+            } else if (header->cmsg_type == SCM_RIGHTS) {
+                usize count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(i32);
+
+                for (usize i = 0; i < count; i++) {
+                    i32 fd;
+
+                    memcpy(&fd, CMSG_DATA(header) + i * sizeof(i32), sizeof(fd));
+                    ::close(fd);
+                }
+            }
+        }
+
+        auto it = _processes.find(pid);
+        if (it == _processes.end()) {
+            LOG_DEBUG("Ignored a notification from unknown pid " + std::to_string(pid));
+            continue;
+        }
+
+        handle(*it->second, std::string_view(buffer, size));
+    }
+}
+
+void NotifySocket::handle(Process& proc, std::string_view message)
+{
+    while (!message.empty()) {
+        usize            end  = message.find('\n');
+        std::string_view line = message.substr(0, end);
+
+        message.remove_prefix(end == std::string_view::npos ? message.size() : end + 1);
+
+        if (line == "READY=1")
+            proc.onReady();
+        else if (line.starts_with("STATUS="))
+            LOG_INFO("Process " + proc.getName() + " status: " + std::string(line.substr(7)));
+    }
+}
+
+NotifySocket& NotifySocket::getInstance()
+{
+    static NotifySocket instance;
+
+    return instance;
+}
+} // namespace taskmasterd
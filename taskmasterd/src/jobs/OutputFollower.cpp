@@ -0,0 +1,75 @@
+#include <taskmasterd/include/jobs/OutputFollower.hpp>
+
+#include <algorithm>
+
+namespace taskmasterd
+{
+OutputFollower::OutputFollower(Callback on_change)
+    : _last(nullptr)
+    , _on_change(std::move(on_change))
+{
+}
+
+OutputFollower::~OutputFollower()
+{
+    clear();
+}
+
+void OutputFollower::follow(const std::string& name, OutputStream& stream)
+{
+    _streams.push_back(Followed{name, &stream, stream.getBuffer().getWritten()});
+    _last = &stream;
+
+    stream.addListener(*this);
+}
+
+void OutputFollower::clear()
+{
+    for (Followed& followed : _streams)
+        followed.stream->removeListener(*this);
+
+    _streams.clear();
+    _last = nullptr;
+}
+
+std::string OutputFollower::collect()
+{
+    std::string output;
+
+    for (Followed& followed : _streams) {
+        const RingBuffer& buffer = followed.stream->getBuffer();
+        u64               kept   = buffer.getWritten() - buffer.getSize();
+
+        if (buffer.getWritten() == followed.offset)
+            continue;
+
+        if (_streams.size() > 1 && _last != followed.stream)
+            output += "\n==> " + followed.name + " <==\n";
+        if (followed.offset < kept)
+            output += "[... " + std::to_string(kept - followed.offset) + " bytes dropped ...]\n";
+
+        output += buffer.readFrom(followed.offset);
+        followed.offset = buffer.getWritten();
+        _last           = followed.stream;
+    }
+    return output;
+}
+
+void OutputFollower::onOutput(OutputStream& stream)
+{
+    // the stream may still call a follower that stopped following it during the same event
+    auto it = std::find_if(_streams.begin(), _streams.end(), [&stream](const Followed& followed) { return followed.stream == &stream; });
+
+    if (it != _streams.end())
+        _on_change();
+}
+
+void OutputFollower::onClosed(OutputStream& stream)
+{
+    std::erase_if(_streams, [&stream](const Followed& followed) { return followed.stream == &stream; });
+    if (_last == &stream)
+        _last = nullptr;
+
+    _on_change();
+}
+} // namespace taskmasterd
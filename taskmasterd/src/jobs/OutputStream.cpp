@@ -0,0 +1,316 @@
+#include <taskmasterd/include/jobs/OutputStream.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fcntl.h>
+#include <filesystem>
+#include <stdexcept>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <logger/include/Logger.hpp>
+#include <taskmasterd/include/core/EventManager.hpp>
+
+namespace taskmasterd
+{
+namespace
+{
+// the size of a single read from the pipe, the default capacity of a pipe
+constexpr usize READ_SIZE = 64 * 1024;
+
+/**
+ * @brief Drop bytes from a pipe, /dev/null takes spliced pages without copying them.
+ *
+ * @return The amount of bytes that were dropped.
+ */
+usize discard(i32 pipe, usize size)
+{
+    static ipc::FileDescriptor null(::open("/dev/null", O_WRONLY | O_CLOEXEC));
+    char                       buffer[4096];
+    usize                      dropped = 0;
+
+    while (dropped < size) {
+        isize moved = splice(pipe, nullptr, null.getFd(), nullptr, size - dropped, SPLICE_F_NONBLOCK);
+
+        if (moved == -1 && errno == EINTR)
+            continue;
+        if (moved == -1)
+            moved = read(pipe, buffer, std::min(sizeof(buffer), size - dropped));
+        if (moved <= 0)
+            break;
+        dropped += moved;
+    }
+    return dropped;
+}
+} // namespace
+
+OutputStream::OutputStream(const std::string& name, usize capacity)
+    : _name(name)
+    , _buffer(capacity)
+    , _splice(isSpliceEnabled())
+    , _tapped(0)
+{
+}
+
+OutputStream::~OutputStream()
+{
+    detach();
+
+    // a listener may remove itself from other streams, it is not called again for this one
+    std::vector<Listener*> listeners = std::move(_listeners);
+    for (Listener* listener : listeners)
+        listener->onClosed(*this);
+}
+
+bool OutputStream::isSpliceEnabled()
+{
+    const char* splice = std::getenv("TASKMASTERD_SPLICE");
+
+    return splice == nullptr || std::string(splice) != "0";
+}
+
+ipc::FileDescriptor OutputStream::open(const std::optional<std::string>& sink, const JobConfig::Rotation& rotation)
+{
+    if (_fd != -1) {
+        onReadable();
+        detach();
+    }
+
+    // the tap is created once and keeps the newest output across runs
+    if (_splice && _tap_read.getFd() == -1) {
+        i32 tap[2];
+
+        if (pipe2(tap, O_CLOEXEC | O_NONBLOCK) == -1) {
+            LOG_WARNING("Failed to create the tap for " + _name + ", copying the output instead: " + strerror(errno));
+            _splice = false;
+        } else {
+            _tap_read  = ipc::FileDescriptor(tap[0]);
+            _tap_write = ipc::FileDescriptor(tap[1]);
+        }
+    }
+
+    // the file is opened by the daemon and appended to, a restart keeps the output of the previous run. The
+    // directory is checked on every run and not when the config is parsed, the parsed config is cached
+    if (sink.has_value()) {
+        std::filesystem::path directory = std::filesystem::path(sink.value()).parent_path();
+        std::error_code       error;
+
+        if (!directory.empty() && !std::filesystem::is_directory(directory, error)) {
+            LOG_WARNING("Directory of " + sink.value() + " does not exist, the output of " + _name + " is only kept in memory");
+        } else {
+            _sink = LogFile::get(sink.value(), rotation);
+        }
+    }
+
+    // both ends are CLOEXEC, dup2 in the child clears the flag on its stdout or stderr
+    i32 ends[2];
+    if (pipe2(ends, O_CLOEXEC) == -1) {
+        _sink.reset();
+        throw std::runtime_error("Failed to create the pipe for " + _name + ": " + strerror(errno));
+    }
+
+    _fd = ends[0];
+    fcntl(_fd, F_SETFL, O_NONBLOCK);
+    EventManager::getInstance().registerEvent(*this, std::bind(&OutputStream::onReadable, this), nullptr);
+
+    return ipc::FileDescriptor(ends[1]);
+}
+
+void OutputStream::setRotation(const JobConfig::Rotation& rotation)
+{
+    if (_sink != nullptr)
+        _sink->setRotation(rotation);
+}
+
+void OutputStream::setJournal(const Journal::Source& source)
+{
+    _journal = source;
+    _splice  = false;
+}
+
+const RingBuffer& OutputStream::getBuffer()
+{
+    flush();
+
+    return _buffer;
+}
+
+void OutputStream::addListener(Listener& listener)
+{
+    _listeners.push_back(&listener);
+}
+
+void OutputStream::removeListener(Listener& listener)
+{
+    std::erase(_listeners, &listener);
+}
+
+void OutputStream::onReadable()
+{
+    if (!_splice || !transfer())
+        copy();
+
+    // a listener may remove itself while it is called
+    std::vector<Listener*> listeners = _listeners;
+    for (Listener* listener : listeners)
+        listener->onOutput(*this);
+}
+
+bool OutputStream::transfer()
+{
+    usize capacity  = _buffer.getCapacity();
+    i32   available = 0;
+
+    // an empty pipe is either closed by the process or the event was spurious, read tells them apart
+    if (ioctl(_fd, FIONREAD, &available) == -1 || available == 0) {
+        copy();
+        return true;
+    }
+
+    // output that arrives in the meantime wakes the event loop again
+    usize remaining = available;
+    while (remaining > 0) {
+        // the tap keeps at most the capacity of the ring buffer, older bytes would be overwritten anyway
+        usize size = std::min(remaining, capacity);
+        if (_tapped + size > capacity)
+            evict(_tapped + size - capacity);
+
+        // with a file the bytes stay in the pipe until they are spliced to it, without one they move into the tap
+        isize moved;
+        if (_sink != nullptr)
+            moved = tee(_fd, _tap_write.getFd(), size, SPLICE_F_NONBLOCK);
+        else
+            moved = splice(_fd, nullptr, _tap_write.getFd(), nullptr, size, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+        if (moved == -1 && errno == EINTR)
+            continue;
+        // small writes take a slot of the tap each, it can run out of slots before it runs out of bytes
+        if (moved == -1 && errno == EAGAIN && _tapped > 0) {
+            flush();
+            continue;
+        }
+        if (moved <= 0) {
+            LOG_WARNING("Failed to splice the output of " + _name + ", copying it instead: " + strerror(errno));
+            _splice = false;
+            return false;
+        }
+
+        _tapped += moved;
+        remaining -= std::min<usize>(moved, remaining);
+        if (_sink != nullptr && !spliceSink(moved))
+            return false;
+    }
+
+    return true;
+}
+
+void OutputStream::copy()
+{
+    char buffer[READ_SIZE];
+
+    while (_fd != -1) {
+        isize size = read(_fd, buffer, sizeof(buffer));
+
+        if (size == -1 && errno == EINTR)
+            continue;
+        if (size == -1 && errno == EAGAIN)
+            return;
+        if (size <= 0) {
+            if (size == -1)
+                LOG_ERROR("Failed to read the output of " + _name + ": " + strerror(errno));
+            detach();
+            return;
+        }
+
+        // the tap holds output that is older than what was still in the pipe
+        flush();
+        _buffer.write(buffer, size);
+        writeSink(buffer, size);
+        if (_journal.has_value())
+            Journal::getInstance().append(_journal.value(), buffer, size);
+    }
+}
+
+bool OutputStream::spliceSink(usize size)
+{
+    while (size > 0) {
+        isize written = _sink->splice(_fd, size);
+
+        if (written == -1 && errno == EINTR)
+            continue;
+        // the file system does not splice, the bytes are in the tap already and only have to reach the file
+        if (written == -1 && errno == EINVAL) {
+            LOG_WARNING("The file of " + _name + " does not support splice, copying the output instead");
+            _splice = false;
+
+            char buffer[READ_SIZE];
+            while (size > 0) {
+                isize moved = read(_fd, buffer, std::min(sizeof(buffer), size));
+
+                if (moved == -1 && errno == EINTR)
+                    continue;
+                if (moved <= 0)
+                    break;
+                writeSink(buffer, moved);
+                size -= moved;
+            }
+            return false;
+        }
+        if (written <= 0) {
+            LOG_ERROR("Failed to write the output of " + _name + ", it is only kept in memory: " + strerror(errno));
+            _sink.reset();
+            break;
+        }
+        size -= written;
+    }
+
+    // without the file the bytes that are in the tap already are dropped from the pipe
+    discard(_fd, size);
+    return true;
+}
+
+void OutputStream::writeSink(const char* data, usize size)
+{
+    if (_sink == nullptr || _sink->write(data, size))
+        return;
+
+    LOG_ERROR("Failed to write the output of " + _name + ", it is only kept in memory: " + strerror(errno));
+    _sink.reset();
+}
+
+void OutputStream::evict(usize size)
+{
+    usize dropped = discard(_tap_read.getFd(), size);
+
+    _buffer.skip(dropped);
+    _tapped -= dropped;
+}
+
+void OutputStream::flush()
+{
+    char buffer[READ_SIZE];
+
+    while (_tapped > 0) {
+        isize size = read(_tap_read.getFd(), buffer, std::min(sizeof(buffer), _tapped));
+
+        if (size == -1 && errno == EINTR)
+            continue;
+        if (size <= 0) {
+            _tapped = 0;
+            return;
+        }
+        _buffer.write(buffer, size);
+        _tapped -= size;
+    }
+}
+
+void OutputStream::detach()
+{
+    if (_fd != -1) {
+        EventManager::getInstance().unregisterEvent(*this);
+        close();
+    }
+    _sink.reset();
+}
+} // namespace taskmasterd
@@ -17,91 +17,138 @@
 
 #include <logger/include/Logger.hpp>
 #include <taskmasterd/include/core/EventManager.hpp>
+#include <taskmasterd/include/jobs/ExecPlan.hpp>
+#include <taskmasterd/include/jobs/Journal.hpp>
+#include <taskmasterd/include/jobs/NotifySocket.hpp>
+#include <taskmasterd/include/jobs/SpawnQueue.hpp>
+#include <taskmasterd/include/jobs/Spawner.hpp>
+#include <taskmasterd/include/jobs/Zygote.hpp>
 #include <utils/include/utils.hpp>
 
 namespace taskmasterd
 {
-Process::Process(const std::string& name, pid_t pgid, Job& job)
+Process::Process(const std::string& name, u32 index, Job& job)
     : _name(name)
     , _pid(-1)
-    , _pgid(pgid)
     , _state(State::STOPPED)
     , _restarts(0)
     , _job(job)
+    , _notify(false)
+    , _parked(false)
+    , _stdout(name + " stdout")
+    , _stderr(name + " stderr")
 {
+    if (Journal::isEnabled()) {
+        _stdout.setJournal(Journal::Source{job.getConfig().name, index, Journal::Stream::STDOUT});
+        _stderr.setJournal(Journal::Source{job.getConfig().name, index, Journal::Stream::STDERR});
+    }
 }
 
-void Process::start(const std::string& path, char* const* argv, char* const* env, const JobConfig& config)
+Process::~Process()
 {
-    // set a timeout that a process needs to stay alive to be a in a valid running state.
-    _timer.reset(new Timer(config.start_time, std::bind(&Process::onStartTime, this)));
-
-    _pid = fork();
-    if (_pid == -1) {
-        throw std::runtime_error("Fork failed for process '" + _name + "': " + strerror(errno));
-    }
-
-    if (_pid == 0) {
-        // Child process
-
-        // Apply privilege de-escalation
-        if (setgid(getgid()) == -1) {
-            LOG_FATAL("Unable to drop privileges");
-            exit(-1);
-        }
+    // give back the place in the queue or the starting slot
+    if (_state == State::QUEUED)
+        SpawnQueue::getInstance().remove(*this);
+    if (_state == State::STARTING)
+        SpawnQueue::getInstance().onStartingChange(-1);
+    if (_notify)
+        NotifySocket::getInstance().unsubscribe(_pid, *this);
+}
 
-        if (setuid(getuid()) == -1) {
-            LOG_FATAL("Unable to drop privileges");
-            exit(-1);
-        }
+void Process::enqueue(i32 priority)
+{
+    if (_state == State::QUEUED)
+        return;
 
-        // If pgid is 0, pid of the child process is used as pgid
-        setpgid(0, _pgid);
-
-        try {
-            if (config.err.has_value()) {
-                LOG_DEBUG("Duping stderr to path: " + config.err.value())
-                dupPath(STDERR_FILENO, config.err.value());
-            }
-            if (config.out.has_value()) {
-                LOG_DEBUG("Duping stdout to path: " + config.out.value())
-                dupPath(STDOUT_FILENO, config.out.value());
-            }
-
-            if (chdir(config.working_dir.c_str()) != 0) {
-                throw std::logic_error("Working Dir Error: " + std::string(strerror(errno)));
-            }
-        } catch (const std::exception& e) {
-            LOG_ERROR("Error executing process " + config.name + " Issue: " + std::string(e.what()));
-            exit(-1);
-        }
+    _timer.reset();
+    clearNextAttempt();
+    setState(State::QUEUED);
 
-        umask(config.umask);
+    SpawnQueue::getInstance().push(*this, priority);
+}
 
-        if (execve(path.c_str(), argv, env) == -1) {
-            LOG_ERROR("Error executing process " + config.name + " Issue: " + std::string(strerror(errno)));
-            exit(EXIT_FAILURE);
-        }
+bool Process::launch()
+{
+    try {
+        _job.launchProcess(*this);
+    } catch (const std::exception& e) {
+        LOG_ERROR(e.what());
+        _job.onLaunchFailed(*this);
+        return false;
+    }
+    return true;
+}
 
-        return;
+void Process::start(const ExecPlan& plan, const JobConfig& config, pid_t pgid)
+{
+    // set a timeout that a process needs to stay alive to be a in a valid running state, a process
+    // that notifies has to report ready within that time instead.
+    _notify = config.notify;
+    _timer.reset(new Timer(config.start_time, std::bind(_notify ? &Process::onStartTimeout : &Process::onStartTime, this)));
+
+    // the write ends only have to stay open in the daemon until the child has its copies
+    ipc::FileDescriptor out = _stdout.open(config.out, config.out_rotation);
+    ipc::FileDescriptor err = _stderr.open(config.err, config.err_rotation);
+
+    SpawnRequest request = plan.getRequest(pgid);
+    SpawnResult  result;
+
+    request.stdout_fd = out.getFd();
+    request.stderr_fd = err.getFd();
+    try {
+        Zygote& zygote = Zygote::getInstance();
+
+        result = zygote.isRunning() ? zygote.spawn(request) : Spawner::getInstance().spawn(request);
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Spawn failed for process '" + _name + "': " + e.what());
     }
 
+    // The child already exited, its exit status will be handled like any other exit
+    if (result.error != 0)
+        LOG_ERROR("Error executing process " + config.name + " Issue: " + result.failed_step + ": " + strerror(result.error));
+
     // Parent Process
-    _state = State::STARTING;
+    _pid   = result.pid;
+    setState(State::STARTING);
+
+    if (_notify)
+        NotifySocket::getInstance().subscribe(_pid, *this);
 
     _timer->start();
 
     LOG_INFO("Started process " + _name + " with PID " + std::to_string(_pid));
-    if ((_fd = pidfd_open(_pid, 0)) == -1)
-        throw std::runtime_error("Failed to open pidfd for process '" + _name + "': " + strerror(errno));
+
+    // close the pidfd of a previous run
+    this->close();
+    _fd = result.pidfd;
 
     EventManager::getInstance().registerEvent(*this, std::bind(&Process::onStateChange, this), nullptr);
 }
 
+void Process::setLogRotation(const JobConfig& config)
+{
+    _stdout.setRotation(config.out_rotation);
+    _stderr.setRotation(config.err_rotation);
+}
+
 void Process::stop(i32 timeout, Signals stop_signal)
 {
-    if (_state == Process::State::BACKOFF || _state == Process::State::EXITED) {
-        _state = Process::State::STOPPED;
+    // a stopped process is reaped already, a stopping one keeps the kill timer of the first request
+    if (_state == Process::State::STOPPED || _state == Process::State::STOPPING)
+        return;
+
+    if (_state == Process::State::QUEUED) {
+        SpawnQueue::getInstance().remove(*this);
+        setState(Process::State::STOPPED);
+        _job.onStop(*this);
+        return;
+    }
+
+    if (_state == Process::State::BACKOFF || _state == Process::State::EXITED || _state == Process::State::FATAL) {
+        // cancel a pending restart
+        _timer.reset();
+        clearNextAttempt();
+        setState(Process::State::STOPPED);
         _job.onStop(*this);
         return;
     }
@@ -118,7 +165,7 @@ void Process::stop(i32 timeout, Signals stop_signal)
 
     LOG_INFO("Sent " + it->first + " to process: " + _name);
 
-    _state = State::STOPPING;
+    setState(State::STOPPING);
 
     // Set up a timer to send SIGKILL if the process does not stop in time
     _timer.reset(new Timer(timeout, [this]() {
@@ -137,7 +184,38 @@ void Process::kill()
 
     LOG_DEBUG("Sent SIGKILL to process: " + _name);
 
-    _state = State::STOPPING;
+    setState(State::STOPPING);
+}
+
+void Process::scheduleStart(TimerWheel::Duration delay, std::function<void()> start)
+{
+    setState(State::BACKOFF);
+
+    if (!_next_attempt.has_value())
+        _job.onScheduledStartChange(1);
+    _next_attempt = std::chrono::system_clock::now() + delay;
+
+    _timer.reset(new Timer(delay, [this, start]() {
+        clearNextAttempt();
+        start();
+    }));
+    _timer->start();
+
+    LOG_INFO("Restarting process " + _name + " in " + std::to_string(delay.count()) + " ms");
+}
+
+void Process::fail()
+{
+    _timer.reset();
+    clearNextAttempt();
+    setState(State::FATAL);
+    _parked = false;
+}
+
+void Process::park()
+{
+    fail();
+    _parked = true;
 }
 
 void Process::onStateChange()
@@ -151,6 +229,8 @@ void Process::onStateChange()
     _timer.reset();
 
     EventManager::getInstance().unregisterEvent(*this);
+    if (_notify)
+        NotifySocket::getInstance().unsubscribe(_pid, *this);
 
     if (WIFEXITED(status))
         return onExit(status);
@@ -158,7 +238,7 @@ void Process::onStateChange()
     if (WIFSIGNALED(status))
         return onForcedExit(status);
 
-    _state = State::UNKNOWN;
+    setState(State::UNKNOWN);
 }
 
 void Process::onExit(i32 status)
@@ -166,17 +246,17 @@ void Process::onExit(i32 status)
     switch (_state) {
     case State::STOPPING:
         LOG_INFO("Process " + _name + " was stopped with status " + std::to_string(WEXITSTATUS(status)));
-        _state = State::STOPPED;
+        setState(State::STOPPED);
         _job.onStop(*this);
         break;
     case State::STARTING:
         LOG_WARNING("Process " + _name + " did not reach the start time! exit code: " + std::to_string(WEXITSTATUS(status)));
-        _state = State::BACKOFF;
+        setState(State::BACKOFF);
         _job.onExit(*this, WEXITSTATUS(status));
         break;
     case State::RUNNING:
         LOG_INFO("Process " + _name + " exited with status " + std::to_string(WEXITSTATUS(status)));
-        _state = State::EXITED;
+        setState(State::EXITED);
         _job.onExit(*this, WEXITSTATUS(status));
         break;
     default:
@@ -187,28 +267,69 @@ void Process::onExit(i32 status)
 void Process::onForcedExit(i32 status)
 {
     LOG_DEBUG("Process " + _name + " terminated by signal " + std::to_string(WTERMSIG(status)));
-    _state = State::STOPPED;
+
+    // a process that was killed before it started is a failed start, with the exit code of a shell
+    if (_state == State::STARTING) {
+        LOG_WARNING("Process " + _name + " did not reach the start time! signal: " + std::to_string(WTERMSIG(status)));
+        setState(State::BACKOFF);
+        _job.onExit(*this, 128 + WTERMSIG(status));
+        return;
+    }
+
+    setState(State::STOPPED);
     _job.onStop(*this);
 }
 
+void Process::setState(State state)
+{
+    if (state == _state)
+        return;
+
+    // the spawn queue limits the amount of processes in the STARTING state
+    if (state == State::STARTING)
+        SpawnQueue::getInstance().onStartingChange(1);
+    if (_state == State::STARTING)
+        SpawnQueue::getInstance().onStartingChange(-1);
+
+    _job.onProcessStateChange(_state, state);
+    _state = state;
+}
+
+void Process::clearNextAttempt()
+{
+    if (!_next_attempt.has_value())
+        return;
+
+    _next_attempt.reset();
+    _job.onScheduledStartChange(-1);
+}
+
 void Process::onStartTime()
 {
     LOG_INFO("Process: " + _name + " successfully surpasses the start time");
-    _state = State::RUNNING;
-    _job.onProcessSurpassedStartTime();
+    setState(State::RUNNING);
+    _job.onProcessSurpassedStartTime(*this);
 }
 
-void Process::dupPath(i32 std_input, const std::string& path)
+void Process::onReady()
 {
-    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
-    if (fd < 0) {
-        throw std::runtime_error("Process: dupPath: failed to open file " + path);
-    }
-    if (dup2(fd, std_input) < 0) {
-        ::close(fd);
-        throw std::runtime_error("Process: dupPath: failed to dup path fd: " + std::to_string(fd) + "path: " + path);
-    }
-    ::close(fd);
+    if (_state != State::STARTING)
+        return;
+
+    _timer.reset();
+
+    LOG_INFO("Process: " + _name + " reported ready");
+    setState(State::RUNNING);
+    _job.onProcessSurpassedStartTime(*this);
+}
+
+void Process::onStartTimeout()
+{
+    LOG_WARNING("Process " + _name + " did not report ready within the start time, sending SIGKILL");
+
+    // the process stays STARTING, its exit counts as a failed start
+    if (pidfd_send_signal(_fd, SIGKILL, NULL, 0) == -1)
+        LOG_ERROR("Failed to send SIGKILL to process: " + _name);
 }
 
 } // namespace taskmasterd
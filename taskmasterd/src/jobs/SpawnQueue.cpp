@@ -0,0 +1,137 @@
+#include <taskmasterd/include/jobs/SpawnQueue.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+#include <logger/include/Logger.hpp>
+#include <taskmasterd/include/jobs/Process.hpp>
+
+namespace taskmasterd
+{
+SpawnQueue::SpawnQueue()
+    : _limits(getLimits())
+    , _sequence(0)
+    , _starting(0)
+    , _tokens(1)
+    , _refilled(Clock::now())
+    , _timer(TimerWheel::Duration(0), std::bind(&SpawnQueue::drain, this))
+{
+    // the wheel has to outlive the timer of the queue
+    TimerWheel::getInstance();
+
+    LOG_INFO("Spawn queue: at most " + (_limits.max_starting != 0 ? std::to_string(_limits.max_starting) : std::string("unlimited")) +
+             " processes starting, " + (_limits.rate != 0 ? std::to_string(_limits.rate) : std::string("unlimited")) + " spawns per second");
+}
+
+static double getLimit(const char* name, double fallback)
+{
+    const char* value = std::getenv(name);
+
+    if (value == nullptr || *value == '\0')
+        return fallback;
+
+    char*  end;
+    double result = std::strtod(value, &end);
+    if (*end != '\0' || result < 0)
+        throw std::runtime_error(std::string("Invalid value for ") + name + ": " + value);
+
+    return result;
+}
+
+SpawnQueue::Limits SpawnQueue::getLimits()
+{
+    return Limits{static_cast<u32>(getLimit("TASKMASTERD_MAX_STARTING", DEFAULT_MAX_STARTING)), getLimit("TASKMASTERD_SPAWN_RATE", 0)};
+}
+
+void SpawnQueue::push(Process& proc, i32 priority)
+{
+    Key key(priority, _sequence++);
+
+    _queue.emplace(key, &proc);
+    _keys.emplace(&proc, key);
+
+    // the process is started on the next tick, so the starts of a whole batch of jobs are ordered
+    schedule();
+}
+
+void SpawnQueue::remove(Process& proc)
+{
+    auto it = _keys.find(&proc);
+
+    if (it == _keys.end())
+        return;
+
+    _queue.erase(it->second);
+    _keys.erase(it);
+}
+
+void SpawnQueue::onStartingChange(i32 delta)
+{
+    _starting += delta;
+
+    // a slot was freed
+    if (delta < 0)
+        schedule();
+}
+
+void SpawnQueue::drain()
+{
+    u32 spawned = 0;
+
+    refill();
+
+    while (!_queue.empty() && spawned < DRAIN_BATCH) {
+        // the processes that finish starting free a slot and schedule the next drain
+        if (_limits.max_starting != 0 && _starting >= _limits.max_starting)
+            return;
+        if (_limits.rate != 0 && _tokens < 1)
+            break;
+
+        auto     it   = _queue.begin();
+        Process* proc = it->second;
+
+        _keys.erase(proc);
+        _queue.erase(it);
+
+        // a process that could not be spawned did not use up the rate
+        if (!proc->launch())
+            continue;
+        _tokens -= _limits.rate != 0 ? 1 : 0;
+        spawned++;
+    }
+
+    // a full batch or an exhausted rate, continue on the next tick after the event loop served its clients
+    schedule();
+}
+
+void SpawnQueue::schedule()
+{
+    if (_queue.empty() || _timer.getState() == Timer::State::RUNNING)
+        return;
+
+    _timer.start();
+}
+
+void SpawnQueue::refill()
+{
+    if (_limits.rate == 0)
+        return;
+
+    Clock::time_point             now     = Clock::now();
+    std::chrono::duration<double> elapsed = now - _refilled;
+    double                        burst   = std::max(1.0, _limits.rate / 10);
+
+    _tokens   = std::min(burst, _tokens + elapsed.count() * _limits.rate);
+    _refilled = now;
+}
+
+SpawnQueue& SpawnQueue::getInstance()
+{
+    static SpawnQueue instance;
+
+    return instance;
+}
+} // namespace taskmasterd
@@ -0,0 +1,153 @@
+#include <taskmasterd/include/jobs/Spawner.hpp>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdexcept>
+#include <string.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace taskmasterd
+{
+namespace
+{
+// the steps a child can fail at, static so a result can point at them
+constexpr const char* DROP_PRIVILEGES_STEP = "Unable to drop privileges";
+constexpr const char* STDERR_STEP          = "Failed to redirect stderr";
+constexpr const char* STDOUT_STEP          = "Failed to redirect stdout";
+constexpr const char* WORKING_DIR_STEP     = "Working Dir Error";
+constexpr const char* EXECUTE_STEP         = "Failed to execute";
+
+/**
+ * @brief State shared between the parent and the child, the child reports its failure through it.
+ */
+struct ChildContext
+{
+    const SpawnRequest* request;
+    sigset_t            mask;
+    i32                 error;
+    const char*         failed_step;
+};
+
+/**
+ * @brief Record the failed step and leave the child, only async-signal-safe calls are allowed here.
+ */
+[[noreturn]] __attribute__((no_sanitize("address"))) void childFail(ChildContext* context, const char* step, i32 status)
+{
+    context->error       = errno;
+    context->failed_step = step;
+    _exit(status);
+}
+} // namespace
+
+Spawner::Spawner()
+{
+    _stack = mmap(nullptr, STACK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (_stack == MAP_FAILED) {
+        throw std::runtime_error("Failed to allocate the spawn stack: " + std::string(strerror(errno)));
+    }
+
+    // the lowest page guards against the child overflowing its stack, without it an overflow corrupts the daemon
+    if (mprotect(_stack, getpagesize(), PROT_NONE) == -1) {
+        std::string error = strerror(errno);
+
+        munmap(_stack, STACK_SIZE);
+        throw std::runtime_error("Failed to protect the guard page of the spawn stack: " + error);
+    }
+}
+
+Spawner::~Spawner()
+{
+    munmap(_stack, STACK_SIZE);
+}
+
+// The child runs inside the memory of the daemon, it must not touch the sanitizer shadow memory of the parent
+__attribute__((no_sanitize("address"))) i32 Spawner::childMain(void* arg)
+{
+    ChildContext*       context = static_cast<ChildContext*>(arg);
+    const SpawnRequest& request = *context->request;
+
+    // The child still has the signal handlers of the daemon, reset them before unblocking signals
+    for (i32 sig = 1; sig < NSIG; sig++) {
+        struct sigaction action;
+
+        if (sigaction(sig, nullptr, &action) != 0 || action.sa_handler == SIG_IGN || action.sa_handler == SIG_DFL)
+            continue;
+        action.sa_handler = SIG_DFL;
+        action.sa_flags   = 0;
+        sigaction(sig, &action, nullptr);
+    }
+    sigprocmask(SIG_SETMASK, &context->mask, nullptr);
+
+    // Apply privilege de-escalation
+    if (setgid(getgid()) == -1)
+        childFail(context, DROP_PRIVILEGES_STEP, -1);
+
+    if (setuid(getuid()) == -1)
+        childFail(context, DROP_PRIVILEGES_STEP, -1);
+
+    setpgid(0, request.pgid);
+
+    // the pipes are CLOEXEC in the daemon, dup2 leaves the copies on the standard streams open across execve
+    if (request.stderr_fd != -1 && dup2(request.stderr_fd, STDERR_FILENO) == -1)
+        childFail(context, STDERR_STEP, -1);
+
+    if (request.stdout_fd != -1 && dup2(request.stdout_fd, STDOUT_FILENO) == -1)
+        childFail(context, STDOUT_STEP, -1);
+
+    if (chdir(request.working_dir) != 0)
+        childFail(context, WORKING_DIR_STEP, -1);
+
+    umask(request.umask);
+
+    // the binary was resolved and opened when the exec plan was built
+    if (request.exec_fd != -1)
+        execveat(request.exec_fd, "", request.argv, request.env, AT_EMPTY_PATH);
+    else
+        execve(request.path, request.argv, request.env);
+    childFail(context, EXECUTE_STEP, EXIT_FAILURE);
+}
+
+SpawnResult Spawner::spawn(const SpawnRequest& request, i32 flags)
+{
+    ChildContext context{&request, {}, 0, nullptr};
+    i32          pidfd = -1;
+    sigset_t     all;
+
+    // Block every signal so no handler of the daemon runs in the child before it resets them
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &context.mask);
+
+    void* stack_top = static_cast<char*>(_stack) + STACK_SIZE;
+    pid_t pid       = clone(&Spawner::childMain, stack_top, CLONE_VM | CLONE_VFORK | CLONE_PIDFD | SIGCHLD | flags, &context, &pidfd);
+    i32   error     = errno;
+
+    pthread_sigmask(SIG_SETMASK, &context.mask, nullptr);
+
+    if (pid == -1) {
+        throw std::runtime_error("Failed to spawn process: " + std::string(strerror(error)));
+    }
+
+    // CLONE_VFORK suspended us until the child called execve or exited, so the context is final
+    return SpawnResult{pid, pidfd, context.error, context.failed_step};
+}
+
+const char* Spawner::findStep(const std::string& step)
+{
+    for (const char* known : {DROP_PRIVILEGES_STEP, STDERR_STEP, STDOUT_STEP, WORKING_DIR_STEP, EXECUTE_STEP}) {
+        if (step == known)
+            return known;
+    }
+    return "Unknown step";
+}
+
+Spawner& Spawner::getInstance()
+{
+    static Spawner instance;
+
+    return instance;
+}
+} // namespace taskmasterd
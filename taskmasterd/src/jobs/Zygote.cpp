@@ -0,0 +1,338 @@
+#include <taskmasterd/include/jobs/Zygote.hpp>
+
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <stdexcept>
+#include <string.h>
+#include <string>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include <logger/include/Logger.hpp>
+#include <proto/taskmaster.pb.h>
+
+namespace taskmasterd
+{
+namespace
+{
+// the most file descriptors passed along with a single message: the pidfd, or the stdout and stderr pipes
+constexpr usize MAX_FDS = 2;
+
+/**
+ * @brief Send a message, optionally passing file descriptors along with it.
+ */
+void sendMessage(i32 socket, const std::string& data, const std::vector<i32>& fds = {})
+{
+    struct iovec  iov{const_cast<char*>(data.data()), data.size()};
+    struct msghdr header{};
+    char          control[CMSG_SPACE(sizeof(i32) * MAX_FDS)]{};
+
+    header.msg_iov    = &iov;
+    header.msg_iovlen = 1;
+
+    if (!fds.empty()) {
+        header.msg_control    = control;
+        header.msg_controllen = CMSG_SPACE(sizeof(i32) * fds.size());
+
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&header);
+        cmsg->cmsg_level     = SOL_SOCKET;
+        cmsg->cmsg_type      = SCM_RIGHTS;
+        cmsg->cmsg_len       = CMSG_LEN(sizeof(i32) * fds.size());
+        memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(i32) * fds.size());
+    }
+
+    isize sent;
+    do {
+        sent = sendmsg(socket, &header, MSG_NOSIGNAL);
+    } while (sent == -1 && errno == EINTR);
+
+    if (sent == -1)
+        throw std::runtime_error("Failed to send message to the zygote: " + std::string(strerror(errno)));
+}
+
+/**
+ * @brief Receive a single message, the file descriptors passed along with it are appended to fds.
+ *
+ * @return false when the other side closed the socket.
+ */
+bool receiveMessage(i32 socket, std::string& data, std::vector<i32>& fds)
+{
+    isize size;
+    char  peek;
+
+    // the socket keeps message boundaries, peek at the size of the next message first
+    do {
+        size = recv(socket, &peek, sizeof(peek), MSG_PEEK | MSG_TRUNC);
+    } while (size == -1 && errno == EINTR);
+
+    if (size == 0)
+        return false;
+    if (size == -1)
+        throw std::runtime_error("Failed to receive message from the zygote: " + std::string(strerror(errno)));
+
+    data.resize(size);
+
+    struct iovec  iov{data.data(), data.size()};
+    struct msghdr header{};
+    char          control[CMSG_SPACE(sizeof(i32) * MAX_FDS)]{};
+
+    header.msg_iov        = &iov;
+    header.msg_iovlen     = 1;
+    header.msg_control    = control;
+    header.msg_controllen = sizeof(control);
+
+    do {
+        size = recvmsg(socket, &header, MSG_CMSG_CLOEXEC);
+    } while (size == -1 && errno == EINTR);
+
+    if (size == -1)
+        throw std::runtime_error("Failed to receive message from the zygote: " + std::string(strerror(errno)));
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&header);
+    if (cmsg != nullptr && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+        usize count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(i32);
+
+        for (usize i = 0; i < count; i++) {
+            i32 received;
+
+            memcpy(&received, CMSG_DATA(cmsg) + i * sizeof(i32), sizeof(i32));
+            fds.push_back(received);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Close the file descriptors that were received with a message.
+ */
+void closeAll(const std::vector<i32>& fds)
+{
+    for (i32 fd : fds)
+        ::close(fd);
+}
+
+/**
+ * @brief Build a null terminated array of pointers into the given strings.
+ */
+std::vector<char*> toArray(const google::protobuf::RepeatedPtrField<std::string>& strings)
+{
+    std::vector<char*> array;
+
+    array.reserve(strings.size() + 1);
+    for (const std::string& string : strings)
+        array.push_back(const_cast<char*>(string.c_str()));
+    array.push_back(nullptr);
+
+    return array;
+}
+} // namespace
+
+Zygote::Zygote()
+    : _pid(-1)
+{
+}
+
+Zygote::~Zygote()
+{
+    shutdown();
+}
+
+bool Zygote::isEnabled()
+{
+    const char* zygote = std::getenv("TASKMASTERD_ZYGOTE");
+
+    return zygote != nullptr && std::string(zygote) == "1";
+}
+
+void Zygote::start()
+{
+    i32 sockets[2];
+
+    // SEQPACKET keeps the message boundaries, CLOEXEC keeps the sockets out of spawned processes
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets) == -1) {
+        throw std::runtime_error("Failed to create the zygote socket: " + std::string(strerror(errno)));
+    }
+
+    pid_t daemon = getpid();
+    pid_t pid    = fork();
+    if (pid == -1) {
+        ::close(sockets[0]);
+        ::close(sockets[1]);
+        throw std::runtime_error("Failed to fork the zygote: " + std::string(strerror(errno)));
+    }
+
+    if (pid == 0) {
+        // the zygote does not outlive the daemon
+        if (prctl(PR_SET_PDEATHSIG, SIGKILL) == -1 || getppid() != daemon)
+            _exit(EXIT_FAILURE);
+
+        // only keep the standard streams and the socket to the daemon
+        ::close(sockets[0]);
+        close_range(3, sockets[1] - 1, 0);
+        close_range(sockets[1] + 1, ~0U, 0);
+        _socket = ipc::FileDescriptor(sockets[1]);
+
+        run();
+    }
+
+    ::close(sockets[1]);
+    _socket = ipc::FileDescriptor(sockets[0]);
+    _pid    = pid;
+
+    LOG_INFO("Started the zygote with PID " + std::to_string(_pid));
+}
+
+void Zygote::run()
+{
+    // terminal signals are meant for the daemon, it shuts the zygote down by closing the socket
+    setpgid(0, 0);
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGQUIT, SIG_DFL);
+    std::signal(SIGHUP, SIG_DFL);
+
+    std::string      data;
+    std::vector<i32> fds;
+    try {
+        while (receiveMessage(_socket.getFd(), data, fds)) {
+            proto::SpawnRequest message;
+
+            if (!message.ParseFromString(data))
+                throw std::runtime_error("Failed to parse protobuf message");
+
+            serve(message, fds);
+            closeAll(fds);
+            fds.clear();
+        }
+    } catch (const std::exception& e) {
+        LOG_FATAL("Zygote: " + std::string(e.what()));
+        _exit(EXIT_FAILURE);
+    }
+
+    _exit(EXIT_SUCCESS);
+}
+
+void Zygote::serve(const proto::SpawnRequest& message, const std::vector<i32>& fds)
+{
+    std::vector<char*> argv = toArray(message.argv());
+    std::vector<char*> env  = toArray(message.env());
+    usize              next = 0;
+
+    SpawnRequest request{};
+    request.path        = message.path().c_str();
+    request.argv        = argv.data();
+    request.env         = env.data();
+    request.working_dir = message.working_dir().c_str();
+    request.pgid        = message.pgid();
+    request.umask       = message.umask();
+
+    // the pipes are passed in order, stdout before stderr
+    if (message.stdout_pipe() && next < fds.size())
+        request.stdout_fd = fds[next++];
+    if (message.stderr_pipe() && next < fds.size())
+        request.stderr_fd = fds[next++];
+
+    proto::SpawnResponse response;
+    SpawnResult          result{-1, -1, 0, nullptr};
+    try {
+        // CLONE_PARENT makes the daemon the parent, it reaps the process through its pidfd
+        result = Spawner::getInstance().spawn(request, CLONE_PARENT);
+        response.set_pid(result.pid);
+        response.set_error(result.error);
+        if (result.failed_step != nullptr)
+            response.set_failed_step(result.failed_step);
+    } catch (const std::exception& e) {
+        // errno is left over from anything by now, the reason is in the message of the exception
+        response.set_pid(-1);
+        response.set_error(EIO);
+        response.set_failed_step(e.what());
+    }
+
+    std::string data;
+    if (!response.SerializeToString(&data))
+        throw std::runtime_error("Failed to serialize the message");
+
+    sendMessage(_socket.getFd(), data, result.pidfd != -1 ? std::vector<i32>{result.pidfd} : std::vector<i32>{});
+    if (result.pidfd != -1)
+        ::close(result.pidfd);
+}
+
+SpawnResult Zygote::spawn(const SpawnRequest& request)
+{
+    proto::SpawnRequest message;
+
+    // the exec fd only exists in the daemon, the zygote executes the resolved path instead
+
+    message.set_path(request.path);
+    for (char* const* arg = request.argv; *arg != nullptr; arg++)
+        message.add_argv(*arg);
+    for (char* const* var = request.env; *var != nullptr; var++)
+        message.add_env(*var);
+    message.set_working_dir(request.working_dir);
+    message.set_pgid(request.pgid);
+    message.set_umask(request.umask);
+
+    // the pipes of the process are passed along with the request
+    std::vector<i32> pipes;
+    if (request.stdout_fd != -1)
+        pipes.push_back(request.stdout_fd);
+    if (request.stderr_fd != -1)
+        pipes.push_back(request.stderr_fd);
+    message.set_stdout_pipe(request.stdout_fd != -1);
+    message.set_stderr_pipe(request.stderr_fd != -1);
+
+    proto::SpawnResponse response;
+    std::vector<i32>     fds;
+    try {
+        std::string data;
+
+        if (!message.SerializeToString(&data))
+            throw std::runtime_error("Failed to serialize the message");
+
+        sendMessage(_socket.getFd(), data, pipes);
+        if (!receiveMessage(_socket.getFd(), data, fds))
+            throw std::runtime_error("the zygote closed the connection");
+        if (!response.ParseFromString(data))
+            throw std::runtime_error("Failed to parse protobuf message");
+    } catch (const std::exception& e) {
+        LOG_ERROR("Zygote is unavailable, spawning from the daemon: " + std::string(e.what()));
+        closeAll(fds);
+        shutdown();
+        return Spawner::getInstance().spawn(request);
+    }
+
+    // only the pidfd is expected, anything else is closed
+    i32 pidfd = fds.empty() ? -1 : fds.front();
+    if (fds.size() > 1)
+        closeAll(std::vector<i32>(fds.begin() + 1, fds.end()));
+
+    if (response.pid() == -1) {
+        throw std::runtime_error("Failed to spawn process: " + response.failed_step() + ": " + strerror(response.error()));
+    }
+
+    // the failed step only lives as long as the response, the zygote fails at the same steps as the Spawner
+    return SpawnResult{response.pid(), pidfd, response.error(), response.error() != 0 ? Spawner::findStep(response.failed_step()) : nullptr};
+}
+
+void Zygote::shutdown()
+{
+    if (_pid == -1)
+        return;
+
+    // closing the socket makes the zygote leave its loop
+    _socket.close();
+    waitpid(_pid, nullptr, 0);
+    _pid = -1;
+}
+
+Zygote& Zygote::getInstance()
+{
+    static Zygote instance;
+
+    return instance;
+}
+} // namespace taskmasterd
@@ -7,6 +7,8 @@
 #include <taskmasterd/include/ipc/Server.hpp>
 #include <taskmasterd/include/jobs/Job.hpp>
 #include <taskmasterd/include/jobs/JobConfig.hpp>
+#include <taskmasterd/include/jobs/Journal.hpp>
+#include <taskmasterd/include/jobs/Zygote.hpp>
 
 #ifndef PROGRAM_NAME
 #define PROGRAM_NAME "taskmasterd"
@@ -27,6 +29,13 @@ int main(int argc, char** argv)
     LOG_INFO("Starting " PROGRAM_NAME);
 
     try {
+        // fork the zygote while the daemon is still small
+        if (Zygote::isEnabled())
+            Zygote::getInstance().start();
+        // a journal that cannot be created stops the daemon instead of losing the output
+        if (Journal::isEnabled())
+            Journal::getInstance();
+
         JobManager manager("./../taskconfig.yaml");
         Server     server(ipc::Socket::Type::UNIX, ipc::Address::UNIX("/tmp/taskmasterd.sock"), manager);
 